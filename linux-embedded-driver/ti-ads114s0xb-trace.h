@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tracepoints of the buffered path, one event per trigger, SPI read and
+ * pushed scan. Enable them with
+ *   echo 1 > /sys/kernel/tracing/events/ads114s0xb/enable
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ads114s0xb
+
+#if !defined(_TI_ADS114S0XB_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TI_ADS114S0XB_TRACE_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(ads114s0xb_trigger,
+	TP_PROTO(const char *dev, s64 timestamp, unsigned int channels,
+		bool drdy),
+	TP_ARGS(dev, timestamp, channels, drdy),
+	TP_STRUCT__entry(
+		__string(dev, dev)
+		__field(s64, timestamp)
+		__field(unsigned int, channels)
+		__field(bool, drdy)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev);
+		__entry->timestamp = timestamp;
+		__entry->channels = channels;
+		__entry->drdy = drdy;
+	),
+	TP_printk("%s timestamp=%lld channels=%u trigger=%s",
+		__get_str(dev), __entry->timestamp, __entry->channels,
+		__entry->drdy ? "drdy" : "scan")
+);
+
+/* RDATA transfer; duration_ns is 0 when the event was enabled mid-read */
+TRACE_EVENT(ads114s0xb_spi_read,
+	TP_PROTO(const char *dev, u64 duration_ns, int ret),
+	TP_ARGS(dev, duration_ns, ret),
+	TP_STRUCT__entry(
+		__string(dev, dev)
+		__field(u64, duration_ns)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev);
+		__entry->duration_ns = duration_ns;
+		__entry->ret = ret;
+	),
+	TP_printk("%s duration=%llu ns ret=%d", __get_str(dev),
+		__entry->duration_ns, __entry->ret)
+);
+
+TRACE_EVENT(ads114s0xb_push,
+	TP_PROTO(const char *dev, s64 timestamp, int ret),
+	TP_ARGS(dev, timestamp, ret),
+	TP_STRUCT__entry(
+		__string(dev, dev)
+		__field(s64, timestamp)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__assign_str(dev, dev);
+		__entry->timestamp = timestamp;
+		__entry->ret = ret;
+	),
+	TP_printk("%s timestamp=%lld ret=%d", __get_str(dev),
+		__entry->timestamp, __entry->ret)
+);
+
+#endif /* _TI_ADS114S0XB_TRACE_H */
+
+/* Found through CFLAGS_ti-ads114s0xb.o := -I$(src) in the Makefile */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE ti-ads114s0xb-trace
+#include <trace/define_trace.h>
@@ -1,19 +1,30 @@
 /* SPDX-License-Identifier: GPL-2.0 */
 #include <asm/unaligned.h>
+#include <linux/bitfield.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
 #include <linux/iio/iio.h>
 #include <linux/iio/sysfs.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/regmap.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spi/spi.h>
 #include <linux/iio/buffer.h>
 #include <linux/iio/kfifo_buf.h>
+#include <linux/iio/trigger.h>
 #include <linux/iio/trigger_consumer.h>
 #include <linux/iio/triggered_buffer.h>
 
+#define CREATE_TRACE_POINTS
+#include "ti-ads114s0xb-trace.h"
+
 /* Command List */
 #define ADS114S0XB_CMD_NOP 0x00
 #define ADS114S0XB_CMD_WAKEUP 0x02
@@ -29,6 +40,9 @@
 #define ADS114S0XB_CMD_WREG 0x40 /* 010r rrrr */
 
 #define ADS114S0XB_NUM_ATTRIBUTES 16
+#define ADS114S0XB_MAX_CHANNELS 12
+/* RDATA, readback, STOP, WREG OFCAL0-FSCAL1, WREG INPMUX, START */
+#define ADS114S0XB_CONV_XFERS 6
 
 /* Registers' Addresses */
 #define ADS114S0XB_REGADDR_ID 0x00
@@ -49,8 +63,49 @@
 #define ADS114S0XB_REGADDR_FSCAL1 0x0f
 #define ADS114S0XB_REGADDR_GPIODAT 0x10
 #define ADS114S0XB_REGADDR_GPIOCON 0x11
+#define ADS114S0XB_NUM_REGS (ADS114S0XB_REGADDR_GPIOCON + 1)
+/* OFCAL0, OFCAL1, reserved, FSCAL0, FSCAL1 */
+#define ADS114S0XB_CAL_REGS (ADS114S0XB_REGADDR_FSCAL1 - ADS114S0XB_REGADDR_OFCAL0 + 1)
 #define ADS114S0XB_REGADDR_MOCK 0xff
 
+/* DATARATE register fields */
+#define ADS114S0XB_DATARATE_MODE BIT(5) /* 1 = single-shot, 0 = continuous */
+#define ADS114S0XB_DATARATE_FILTER BIT(4) /* 1 = low-latency, 0 = sinc3 */
+#define ADS114S0XB_DATARATE_DR_MASK GENMASK(3, 0)
+#define ADS114S0XB_DATARATE_DEFAULT 0x14
+
+/* PGA register fields */
+#define ADS114S0XB_PGA_DELAY_MASK GENMASK(7, 5)
+#define ADS114S0XB_PGA_DEFAULT 0x00
+
+/* SYS register fields */
+#define ADS114S0XB_SYS_CAL_SAMP_MASK GENMASK(4, 3)
+
+/* Default sampling_frequency of the timer trigger, in mHz */
+#define ADS114S0XB_RATE_DEFAULT_MHZ 100000
+
+/* Modulator period, 16 / 4.096 MHz internal oscillator */
+#define ADS114S0XB_TMOD_NS 3907
+
+/* Output data rate in mSPS, indexed by DATARATE[3:0] */
+static const unsigned int ads114s0xb_data_rates_msps[] = {
+	2500, 5000, 10000, 16600, 20000, 50000, 60000, 100000,
+	200000, 400000, 800000, 1000000, 2000000, 4000000, 4000000, 4000000,
+};
+
+/* Conversions averaged by a calibration command, indexed by SYS[4:3] */
+static const unsigned int ads114s0xb_cal_samples[] = { 1, 4, 8, 16 };
+
+/* OFCAL0..FSCAL1 after reset: no offset, gain 1 */
+static const u8 ads114s0xb_cal_reset[ADS114S0XB_CAL_REGS] = {
+	0x00, 0x00, 0x00, 0x00, 0x40,
+};
+
+/* Conversion start delay in modulator periods, indexed by PGA[7:5] */
+static const unsigned int ads114s0xb_start_delay_tmod[] = {
+	14, 25, 64, 256, 1024, 2048, 4096, 1,
+};
+
 enum ads114s0xb {
 	ADS114S06B_ID,
 	ADS114S08B_ID,
@@ -58,18 +113,99 @@ enum ads114s0xb {
 
 struct ads114s0xb_chip_info {
 	const struct iio_chan_spec *channels;
-	unsigned int num_channels;
+	unsigned int num_channels; /* analog inputs, timestamp excluded */
+};
+
+/*
+ * debugfs "stats" counters, updated under priv->lock. Handler latency runs
+ * from the trigger edge (pf->timestamp) to the end of the handler.
+ */
+struct ads114s0xb_stats {
+	u64 triggers;
+	u64 conversions;
+	u64 scans;
+	u64 spi_errors;
+	u64 push_errors;
+	u64 latency_min_ns;
+	u64 latency_max_ns;
+	u64 latency_sum_ns;
+};
+
+/* One packed scan: every enabled channel, then the timestamp */
+struct ads114s0xb_scan {
+	s16 samples[ADS114S0XB_MAX_CHANNELS];
+	s64 timestamp __aligned(8);
 };
 
+/* Command bytes and readbacks of the pre-built conversion messages */
+struct ads114s0xb_conv_buf {
+	u8 start;
+	u8 stop;
+	u8 rdata[4]; /* RDATA, then the NOPs clocked out by the readback */
+	u8 mux[ADS114S0XB_MAX_CHANNELS][3]; /* WREG INPMUX, scan_order[i] */
+	/* WREG OFCAL0, count, calib[scan_order[i]] */
+	u8 cal[ADS114S0XB_MAX_CHANNELS][ADS114S0XB_CAL_REGS + 2];
+	u8 rx[ADS114S0XB_MAX_CHANNELS][4];
+};
+
+static bool async_spi;
+module_param(async_spi, bool, 0644);
+MODULE_PARM_DESC(async_spi,
+	"DRDY trigger: push each scan while the next SPI message is in flight (one DRDY later)");
+
 struct ads114s0xb_private {
-	u32 buffer[256] __aligned(8);
+	struct ads114s0xb_scan scan;
+	/* Finished scan waiting to be pushed, with async_spi */
+	struct ads114s0xb_scan scan_out;
+	s64 scan_out_timestamp;
+	bool scan_out_ready;
+	/* Enabled channels in scan order, rebuilt by update_scan_mode */
+	u8 scan_order[ADS114S0XB_MAX_CHANNELS];
+	unsigned int scan_count;
+	/* Next scan_order entry expected on DRDY in continuous mode */
+	unsigned int scan_pos;
 	u8 data[5] __aligned(IIO_DMA_MINALIGN);
+	/* WREG opcode, count and register data, used by the regmap bus */
+	u8 reg_tx[ADS114S0XB_NUM_REGS + 2] __aligned(IIO_DMA_MINALIGN);
+	struct regmap *regmap;
 	struct spi_device *spi;
 	struct gpio_desc *reset_gpio;
 	const struct ads114s0xb_chip_info *chip_info;
 	struct mutex lock;
 	int mock_flag;
 	u16 mock_data;
+	struct completion drdy_done; /* DRDY seen during a direct read */
+	/* DRDY trigger, fed by the DRDY irq or emulated by drdy_timer */
+	struct iio_trigger *drdy_trig;
+	int drdy_irq;
+	bool drdy_emulated;
+	u64 drdy_period_ns;
+	struct hrtimer drdy_timer;
+	/* Timer trigger: one scan per rate_timer period */
+	struct iio_trigger *rate_trig;
+	unsigned int rate_mhz; /* requested sampling_frequency */
+	u64 rate_period_ns;
+	struct hrtimer rate_timer;
+	struct ads114s0xb_stats stats;
+	/*
+	 * OFCAL0..FSCAL1 per channel, loaded by the conversion messages when
+	 * a scan switches to the channel; only channels in calib_valid
+	 */
+	u8 calib[ADS114S0XB_MAX_CHANNELS][ADS114S0XB_CAL_REGS];
+	DECLARE_BITMAP(calib_valid, ADS114S0XB_MAX_CHANNELS);
+	/*
+	 * OFCAL0..FSCAL1 as they were at buffer enable: loaded for the scan's
+	 * channels without an entry, and restored by postdisable
+	 */
+	u8 calib_saved[ADS114S0XB_CAL_REGS];
+	bool calib_restore;
+	bool calib_scan; /* some channel of the scan has an entry */
+	/* One message per scan position, built by ads114s0xb_prepare_messages() */
+	struct spi_message conv_msg[ADS114S0XB_MAX_CHANNELS + 1];
+	struct spi_transfer conv_xfer[ADS114S0XB_MAX_CHANNELS + 1][ADS114S0XB_CONV_XFERS];
+	struct completion conv_done;
+	bool conv_async; /* async_spi, sampled when the messages are built */
+	struct ads114s0xb_conv_buf conv_buf __aligned(IIO_DMA_MINALIGN);
 };
 
 #define ADS114S0XB_CHAN(index)                                                 \
@@ -96,6 +232,7 @@ static const struct iio_chan_spec ads114s0xb06_channels[] = {
 	ADS114S0XB_CHAN(3), 
 	ADS114S0XB_CHAN(4),
 	ADS114S0XB_CHAN(5),
+	IIO_CHAN_SOFT_TIMESTAMP(6),
 };
 
 static const struct iio_chan_spec ads114s0xb08_channels[] = {
@@ -103,28 +240,142 @@ static const struct iio_chan_spec ads114s0xb08_channels[] = {
 	ADS114S0XB_CHAN(3), ADS114S0XB_CHAN(4),  ADS114S0XB_CHAN(5),
 	ADS114S0XB_CHAN(6), ADS114S0XB_CHAN(7),  ADS114S0XB_CHAN(8),
 	ADS114S0XB_CHAN(9), ADS114S0XB_CHAN(10), ADS114S0XB_CHAN(11),
+	IIO_CHAN_SOFT_TIMESTAMP(12),
 };
 static const struct ads114s0xb_chip_info ads114s0xb_chip_info_tbl[] = {
 	[ADS114S06B_ID] =
 		{
 			.channels = ads114s0xb06_channels,
-			.num_channels = ARRAY_SIZE(ads114s0xb06_channels),
+			.num_channels = ARRAY_SIZE(ads114s0xb06_channels) - 1,
 		},
 	[ADS114S08B_ID] =
 		{
 			.channels = ads114s0xb08_channels,
-			.num_channels = ARRAY_SIZE(ads114s0xb08_channels),
+			.num_channels = ARRAY_SIZE(ads114s0xb08_channels) - 1,
 		},
 };
 
+/*
+ * regmap bus: the RREG/WREG opcodes carry the start address and the
+ * number of registers minus one, so a regmap raw access of any length is
+ * a single SPI transfer.
+ */
+static int ads114s0xb_regmap_write(void *context, const void *data,
+	size_t count)
+{
+	struct ads114s0xb_private *priv = context;
+	const u8 *buf = data; /* register address, then values */
+
+	if (count < 2 || count - 1 > ADS114S0XB_NUM_REGS)
+		return -EINVAL;
+
+	priv->reg_tx[0] = ADS114S0XB_CMD_WREG | buf[0];
+	priv->reg_tx[1] = count - 2; /* number of registers to write (minus 1) */
+	memcpy(&priv->reg_tx[2], &buf[1], count - 1);
+
+	return spi_write(priv->spi, priv->reg_tx, count + 1);
+}
+
+static int ads114s0xb_regmap_read(void *context, const void *reg_buf,
+	size_t reg_size, void *val_buf, size_t val_size)
+{
+	struct ads114s0xb_private *priv = context;
+	const u8 *reg = reg_buf;
+	u8 cmd[2];
+	size_t i;
+
+	if (val_size < 1 || val_size > ADS114S0XB_NUM_REGS)
+		return -EINVAL;
+
+	if (priv->mock_flag != 0) {
+		for (i = 0; i < val_size; i++)
+			((u8 *)val_buf)[i] = priv->mock_data++;
+		return 0;
+	}
+
+	cmd[0] = ADS114S0XB_CMD_RREG | reg[0];
+	cmd[1] = val_size - 1; /* number of registers to read (minus 1) */
+
+	return spi_write_then_read(priv->spi, cmd, 2, val_buf, val_size);
+}
+
+static const struct regmap_bus ads114s0xb_regmap_bus = {
+	.write = ads114s0xb_regmap_write,
+	.read = ads114s0xb_regmap_read,
+};
+
+/*
+ * STATUS flags and GPIO input levels change behind the driver's back. ID
+ * is read-only: the chip ignores writes, so a cached ID could be changed
+ * by a write the chip never took.
+ */
+static bool ads114s0xb_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case ADS114S0XB_REGADDR_ID:
+	case ADS114S0XB_REGADDR_STATUS:
+	case ADS114S0XB_REGADDR_GPIODAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Power-on values; ID is volatile and always read from the chip */
+static const struct reg_default ads114s0xb_reg_defaults[] = {
+	{ ADS114S0XB_REGADDR_INPMUX, 0x01 },
+	{ ADS114S0XB_REGADDR_PGA, ADS114S0XB_PGA_DEFAULT },
+	{ ADS114S0XB_REGADDR_DATARATE, ADS114S0XB_DATARATE_DEFAULT },
+	{ ADS114S0XB_REGADDR_REF, 0x10 },
+	{ ADS114S0XB_REGADDR_IDACMAG, 0x00 },
+	{ ADS114S0XB_REGADDR_IDACMUX, 0xff },
+	{ ADS114S0XB_REGADDR_VBIAS, 0x00 },
+	{ ADS114S0XB_REGADDR_SYS, 0x10 },
+	{ 0x0a, 0x00 }, /* reserved */
+	{ ADS114S0XB_REGADDR_OFCAL0, 0x00 },
+	{ ADS114S0XB_REGADDR_OFCAL1, 0x00 },
+	{ 0x0d, 0x00 }, /* reserved */
+	{ ADS114S0XB_REGADDR_FSCAL0, 0x00 },
+	{ ADS114S0XB_REGADDR_FSCAL1, 0x40 },
+	{ ADS114S0XB_REGADDR_GPIOCON, 0x00 },
+};
+
+static const struct regmap_config ads114s0xb_regmap_config = {
+	.reg_bits = 8,
+	.val_bits = 8,
+	.max_register = ADS114S0XB_REGADDR_GPIOCON,
+	.volatile_reg = ads114s0xb_volatile_reg,
+	.reg_defaults = ads114s0xb_reg_defaults,
+	.num_reg_defaults = ARRAY_SIZE(ads114s0xb_reg_defaults),
+	.cache_type = REGCACHE_RBTREE,
+};
+
 static int ads114s0xb_write_reg(struct iio_dev *indio_dev, u8 reg, u8 data)
 {
 	struct ads114s0xb_private *priv = iio_priv(indio_dev);
-	priv->data[0] = ADS114S0XB_CMD_WREG | reg;
-	priv->data[1] = 0x0;  /* number of registers to write (minus 1) */
-	priv->data[2] = data; /* register data to be written */
 
-	return spi_write(priv->spi, &priv->data[0], 3);
+	return regmap_write(priv->regmap, reg, data);
+}
+
+/*
+ * Burst helpers: count consecutive registers starting at reg. Writes are a
+ * single WREG transfer; reads are served from the cache, only volatile
+ * registers reach the bus.
+ */
+static int ads114s0xb_write_regs(struct iio_dev *indio_dev, u8 reg,
+	const u8 *vals, size_t count)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	return regmap_bulk_write(priv->regmap, reg, vals, count);
+}
+
+static int ads114s0xb_read_regs(struct iio_dev *indio_dev, u8 reg,
+	u8 *vals, size_t count)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	return regmap_bulk_read(priv->regmap, reg, vals, count);
 }
 #if 0
 static int ads114s0xb_read_data(struct iio_dev *indio_dev, int *data)
@@ -144,9 +395,21 @@ static int ads114s0xb_read_data(struct iio_dev *indio_dev, int *data)
 	return 0;
 }
 #endif
+/* RDATA result at rx; SENSOR_MOCK_MODE replaces it with the mock counter */
+static int ads114s0xb_result(struct ads114s0xb_private *priv, u8 *rx)
+{
+	if (priv->mock_flag != 0) {
+		memcpy(rx, &priv->mock_data, sizeof priv->mock_data);
+		priv->mock_data++;
+	}
+
+	return get_unaligned_be16(rx);
+}
+
 static int ads114s0xb_read(struct iio_dev *indio_dev)
 {
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	u64 start = 0;
 	int ret;
 	struct spi_transfer t[] = {
 		{
@@ -166,46 +429,36 @@ static int ads114s0xb_read(struct iio_dev *indio_dev)
 		ADS114S0XB_CMD_NOP, 
 		sizeof(ads114s0xb_priv->data) - 1);
 
+	/* The clock is only read while the event is enabled */
+	if (trace_ads114s0xb_spi_read_enabled())
+		start = ktime_get_ns();
 	ret = spi_sync_transfer(
 		ads114s0xb_priv->spi, t, 
 		ARRAY_SIZE(t));
-	if (ret < 0)
+	trace_ads114s0xb_spi_read(dev_name(&indio_dev->dev),
+		start ? ktime_get_ns() - start : 0, ret);
+	if (ret < 0) {
+		ads114s0xb_priv->stats.spi_errors++;
 		return ret;
-
-	if (ads114s0xb_priv->mock_flag != 0) {
-		memcpy(&ads114s0xb_priv->data[2],
-			&ads114s0xb_priv->mock_data,
-			sizeof ads114s0xb_priv->mock_data);
-		ads114s0xb_priv->mock_data++;
 	}
+	ads114s0xb_priv->stats.conversions++;
 
-	return get_unaligned_be16(&ads114s0xb_priv->data[2]);
+	return ads114s0xb_result(ads114s0xb_priv, &ads114s0xb_priv->data[2]);
 }
 
+/* Served from the register cache unless the register is volatile */
 static int ads114s0xb_read_reg(struct iio_dev *indio_dev, u8 reg, u8 *data)
 {
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
-	int ret = 0;
-	ads114s0xb_priv->data[0] = ADS114S0XB_CMD_RREG | reg;
-	ads114s0xb_priv->data[1] = 0x00; /* reading one register => 0x00 */
-
-	
+	unsigned int val;
+	int ret;
 
-	if (ads114s0xb_priv->mock_flag != 0) {
-		*data = ads114s0xb_priv->mock_data;
-		ads114s0xb_priv->mock_data++;
-	}
-	else {
-		ret =
-			spi_write_then_read(ads114s0xb_priv->spi, 
-				&ads114s0xb_priv->data[0], 2, 
-				&ads114s0xb_priv->data[2], 1);
-		if (ret < 0) {
-			pr_info("ads114s0xb: Not able to read register");
-			return ret;
-		}
-		*data = ads114s0xb_priv->data[2];
+	ret = regmap_read(ads114s0xb_priv->regmap, reg, &val);
+	if (ret < 0) {
+		pr_info("ads114s0xb: Not able to read register");
+		return ret;
 	}
+	*data = val;
 
 	return 1;
 }
@@ -220,17 +473,102 @@ static int ads114s0xb_write_cmd(struct iio_dev *indio_dev, u8 command)
 }
 
 
+/*
+ * Time from START to the first settled result: the programmable start
+ * delay plus one data period with the low-latency filter, three with sinc3,
+ * and a 10% margin for the internal oscillator tolerance.
+ */
+static unsigned int ads114s0xb_conversion_time_us(
+	struct ads114s0xb_private *priv)
+{
+	unsigned int datarate = ADS114S0XB_DATARATE_DEFAULT;
+	unsigned int pga = ADS114S0XB_PGA_DEFAULT;
+	unsigned int rate, periods;
+	u64 ns;
+
+	/* Both come from the register cache, no SPI traffic */
+	regmap_read(priv->regmap, ADS114S0XB_REGADDR_DATARATE, &datarate);
+	regmap_read(priv->regmap, ADS114S0XB_REGADDR_PGA, &pga);
+
+	rate = ads114s0xb_data_rates_msps[datarate & ADS114S0XB_DATARATE_DR_MASK];
+	periods = (datarate & ADS114S0XB_DATARATE_FILTER) ? 1 : 3;
+
+	ns = div_u64(periods * 1000000000000ULL, rate);
+	ns += (u64)ads114s0xb_start_delay_tmod[
+		FIELD_GET(ADS114S0XB_PGA_DELAY_MASK, pga)] * ADS114S0XB_TMOD_NS;
+
+	return DIV_ROUND_UP_ULL(ns + div_u64(ns, 10), NSEC_PER_USEC);
+}
+
+/*
+ * Timer trigger rate. Each scan converts every enabled channel in turn, so
+ * sampling_frequency is clamped to what the current DATARATE and PGA
+ * start delay allow for that many conversions.
+ */
+static unsigned int ads114s0xb_rate_max_mhz(struct ads114s0xb_private *priv)
+{
+	unsigned int us = ads114s0xb_conversion_time_us(priv) *
+		max(priv->scan_count, 1U);
+
+	return max(1000000000U / us, 1U);
+}
+
+/* Called with priv->lock held */
+static unsigned int ads114s0xb_rate_mhz(struct ads114s0xb_private *priv)
+{
+	return min(priv->rate_mhz, ads114s0xb_rate_max_mhz(priv));
+}
+
+/*
+ * Called with priv->lock held whenever the clamp may have moved: a new
+ * sampling_frequency, scan, DATARATE or PGA. A running timer takes the
+ * new period at its next expiry.
+ */
+static void ads114s0xb_rate_update(struct ads114s0xb_private *priv)
+{
+	WRITE_ONCE(priv->rate_period_ns,
+		div_u64(1000000000000ULL, ads114s0xb_rate_mhz(priv)));
+}
+
+/*
+ * Waits for the conversion started by START: on the DRDY edge when the
+ * line is wired, otherwise by sleeping for the computed conversion time.
+ * Called with priv->lock held and the DRDY irq armed by the caller.
+ */
+static int ads114s0xb_wait_conversion(struct iio_dev *indio_dev,
+	bool use_drdy)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	unsigned int us = ads114s0xb_conversion_time_us(priv);
+
+	if (use_drdy) {
+		if (!wait_for_completion_timeout(&priv->drdy_done,
+				usecs_to_jiffies(2 * us) + 1))
+			return -ETIMEDOUT;
+		return 0;
+	}
+
+	fsleep(us);
+	return 0;
+}
+
 static int ads114s0xb_read_raw(struct iio_dev *indio_dev,
 			       struct iio_chan_spec const *chan, int *val,
 			       int *val2, long mask)
 {
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	bool use_drdy;
 	int ret;
 
-	mutex_lock(&ads114s0xb_priv->lock);
 	switch (mask) {
 	case IIO_CHAN_INFO_RAW:
-		pr_info("ads114s0xb: Reading channel %d\n", chan->channel);
+		/* Direct reads would corrupt a running buffered scan */
+		ret = iio_device_claim_direct_mode(indio_dev);
+		if (ret)
+			return ret;
+
+		mutex_lock(&ads114s0xb_priv->lock);
+		dev_dbg(&indio_dev->dev, "Reading channel %d\n", chan->channel);
 		ret = ads114s0xb_write_reg(indio_dev, 
 			ADS114S0XB_REGADDR_INPMUX,
 			chan->channel);
@@ -239,18 +577,31 @@ static int ads114s0xb_read_raw(struct iio_dev *indio_dev,
 				"Set ADC CH failed\n");
 			goto output;
 		}
+
+		use_drdy = ads114s0xb_priv->drdy_irq > 0 &&
+			!ads114s0xb_priv->mock_flag;
+		if (use_drdy) {
+			reinit_completion(&ads114s0xb_priv->drdy_done);
+			enable_irq(ads114s0xb_priv->drdy_irq);
+		}
+
 		ret = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_START);
 		if (ret) {
 			dev_err(&ads114s0xb_priv->spi->dev, 
 				"Start conversions failed\n");
-			goto output;
+		} else {
+			ret = ads114s0xb_wait_conversion(indio_dev, use_drdy);
 		}
-		
-		mdelay(407);
 
-		*val = ads114s0xb_read(indio_dev);
+		if (use_drdy)
+			disable_irq(ads114s0xb_priv->drdy_irq);
+		if (ret)
+			goto output;
 
-		*val = 42;
+		ret = ads114s0xb_read(indio_dev);
+		if (ret < 0)
+			goto output;
+		*val = sign_extend32(ret, 15);
 
 		ret = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_STOP);
 		if (ret) {
@@ -260,13 +611,14 @@ static int ads114s0xb_read_raw(struct iio_dev *indio_dev,
 		}
 
 		ret = IIO_VAL_INT;
+output:
+		mutex_unlock(&ads114s0xb_priv->lock);
+		iio_device_release_direct_mode(indio_dev);
 		break;
 	default:
 		ret = -EINVAL;
 		break;
 	}
-output:
-	mutex_unlock(&ads114s0xb_priv->lock);
 	return ret;
 }
 
@@ -278,9 +630,16 @@ static ssize_t ads114s0xb_attr_get(struct device *dev,
 	int ret;
 	u8 val;
 
-	pr_info("ads114s0xb: Attribute %s to be read\n", attr->attr.name);
+	if (iio_attr->address == ADS114S0XB_REGADDR_MOCK) {
+		struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+		return scnprintf(buf, PAGE_SIZE, "%d\n", priv->mock_flag);
+	}
+
 	ret = ads114s0xb_read_reg(indio_dev, (u8)(iio_attr->address), &val);
-	pr_info("ads114s0xb: ads114s0xb_read_reg ret = %d, val = %x\n", ret, val);
+	if (ret < 0)
+		return ret;
+	dev_dbg(dev, "%s read as %#x\n", attr->attr.name, val);
 
 	return scnprintf(buf, PAGE_SIZE, "%u\n", val);
 }
@@ -294,8 +653,6 @@ static ssize_t ads114s0xb_attr_set(struct device *dev,
 	struct iio_dev_attr *iio_attr = to_iio_dev_attr(attr);
 	int val;
 
-	pr_info("ads114s0xb: Setting attribute %s\n", attr->attr.name);
-
 	if (kstrtoint(buf, 10, &val) < 0)
 		return -EINVAL;
 	if (val < 0)
@@ -315,35 +672,210 @@ static ssize_t ads114s0xb_attr_set(struct device *dev,
 
 	mutex_lock(&ads114s0xb_priv->lock);
 	ads114s0xb_write_reg(indio_dev, (u8)(iio_attr->address), val);
+	if (iio_attr->address == ADS114S0XB_REGADDR_PGA ||
+	    iio_attr->address == ADS114S0XB_REGADDR_DATARATE)
+		ads114s0xb_rate_update(ads114s0xb_priv);
 	mutex_unlock(&ads114s0xb_priv->lock);
 
-	pr_info("ads114s0xb: Attribute %s set to %d\n", attr->attr.name, val);
+	dev_dbg(dev, "%s set to %d\n", attr->attr.name, val);
+	return count;
+}
+
+/*
+ * "calibrate": SYOCAL, SYGCAL or SFOCAL on the input INPMUX selects, with
+ * the current PGA and DATARATE. The chip averages CAL_SAMP (SYS[4:3])
+ * conversions and writes OFCAL or FSCAL itself, so those registers are
+ * dropped from the cache and read from the chip on the next access.
+ * SYOCAL and SYGCAL expect the system's zero and full-scale input to be
+ * applied. Blocks until the calibration is done.
+ */
+static ssize_t ads114s0xb_calibrate_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(dev);
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	unsigned int sys = 0;
+	unsigned int us;
+	int ret, err;
+	u8 cmd;
+
+	if (sysfs_streq(buf, "SYOCAL"))
+		cmd = ADS114S0XB_CMD_SYOCAL;
+	else if (sysfs_streq(buf, "SYGCAL"))
+		cmd = ADS114S0XB_CMD_SYGCAL;
+	else if (sysfs_streq(buf, "SFOCAL"))
+		cmd = ADS114S0XB_CMD_SFOCAL;
+	else
+		return -EINVAL;
+
+	/* Not while a buffered scan owns the chip */
+	ret = iio_device_claim_direct_mode(indio_dev);
+	if (ret)
+		return ret;
+
+	mutex_lock(&priv->lock);
+	regmap_read(priv->regmap, ADS114S0XB_REGADDR_SYS, &sys);
+	/* The averaged conversions, plus the one the command restarts */
+	us = ads114s0xb_conversion_time_us(priv) * (1 +
+		ads114s0xb_cal_samples[FIELD_GET(ADS114S0XB_SYS_CAL_SAMP_MASK, sys)]);
+
+	ret = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_START);
+	if (ret == 0)
+		ret = ads114s0xb_write_cmd(indio_dev, cmd);
+	if (ret == 0)
+		fsleep(us);
+	err = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_STOP);
+	if (ret == 0)
+		ret = err;
+
+	regcache_drop_region(priv->regmap, ADS114S0XB_REGADDR_OFCAL0,
+		ADS114S0XB_REGADDR_FSCAL1);
+	mutex_unlock(&priv->lock);
+	iio_device_release_direct_mode(indio_dev);
+
+	if (ret) {
+		dev_err(dev, "calibration command %#x failed\n", cmd);
+		return ret;
+	}
+	dev_dbg(dev, "calibration command %#x done in %u us\n", cmd, us);
+
 	return count;
 }
 
+/*
+ * Both triggers belong to this device, so iio_trigger_using_own() cannot
+ * tell them apart.
+ */
+static bool ads114s0xb_using_drdy(struct iio_dev *indio_dev)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	return indio_dev->trig == priv->drdy_trig;
+}
+
+/*
+ * Builds the SPI messages of a scan from scan_order, one per conversion,
+ * so the trigger handler only submits them and every command byte is
+ * sent without a round trip of its own. Per-scan triggers: conv_msg[0]
+ * selects and starts the first channel, conv_msg[i + 1] reads channel i
+ * back, stops, then selects and starts channel i + 1. DRDY: conv_msg[i]
+ * reads channel i back and selects the next one, the ADC keeps
+ * converting. Once a channel of the scan has a "calibration" entry,
+ * every channel gets its OFCAL/FSCAL written right before it is selected:
+ * its entry, or calib_saved for the others. CS is released between
+ * commands, as with separate calls. Called with priv->lock held.
+ */
+static void ads114s0xb_prepare_messages(struct iio_dev *indio_dev)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	struct ads114s0xb_conv_buf *buf = &priv->conv_buf;
+	unsigned int count = priv->scan_count;
+	bool drdy = ads114s0xb_using_drdy(indio_dev);
+	bool mux = count > 1;
+	struct spi_transfer *xfer;
+	unsigned int i, j, n, next;
+
+	buf->start = ADS114S0XB_CMD_START;
+	buf->stop = ADS114S0XB_CMD_STOP;
+	buf->rdata[0] = ADS114S0XB_CMD_RDATA;
+	memset(&buf->rdata[1], ADS114S0XB_CMD_NOP, sizeof(buf->rdata) - 1);
+	for (i = 0; i < count; i++) {
+		buf->mux[i][0] = ADS114S0XB_CMD_WREG | ADS114S0XB_REGADDR_INPMUX;
+		buf->mux[i][1] = 0; /* one register */
+		buf->mux[i][2] = priv->scan_order[i];
+		buf->cal[i][0] = ADS114S0XB_CMD_WREG | ADS114S0XB_REGADDR_OFCAL0;
+		buf->cal[i][1] = ADS114S0XB_CAL_REGS - 1;
+		memcpy(&buf->cal[i][2],
+			test_bit(priv->scan_order[i], priv->calib_valid) ?
+			priv->calib[priv->scan_order[i]] : priv->calib_saved,
+			ADS114S0XB_CAL_REGS);
+	}
+
+	priv->conv_async = drdy && async_spi;
+	priv->scan_out_ready = false;
+	for (i = 0; i <= count; i++) {
+		xfer = priv->conv_xfer[i];
+		memset(priv->conv_xfer[i], 0, sizeof(priv->conv_xfer[i]));
+		n = 0;
+
+		/* Readback of the channel converted before this message */
+		if (drdy ? i < count : i > 0) {
+			xfer[n].tx_buf = buf->rdata;
+			xfer[n++].len = 3;
+			xfer[n].tx_buf = &buf->rdata[1];
+			xfer[n].rx_buf = buf->rx[drdy ? i : i - 1];
+			xfer[n++].len = 3;
+		}
+		if (!drdy && i > 0) {
+			xfer[n].tx_buf = &buf->stop;
+			xfer[n++].len = 1;
+		}
+		next = drdy ? (i + 1) % count : i;
+		if (mux && i < count && priv->calib_scan) {
+			xfer[n].tx_buf = buf->cal[next];
+			xfer[n++].len = sizeof(buf->cal[next]);
+		}
+		if (mux && i < count) {
+			xfer[n].tx_buf = buf->mux[next];
+			xfer[n++].len = 3;
+		}
+		if (!drdy && i < count) {
+			xfer[n].tx_buf = &buf->start;
+			xfer[n++].len = 1;
+		}
+
+		for (j = 0; j + 1 < n; j++)
+			xfer[j].cs_change = 1;
+		spi_message_init_with_transfers(&priv->conv_msg[i],
+			priv->conv_xfer[i], n);
+	}
+}
+
 static int ads114s0xb_update_scan_mode(struct iio_dev *indio_dev,
 	const unsigned long *scan_mask)
 {
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
-	int i, enabled_channel = -1;
-
-	pr_info("ads114s0xb_update_scan_mode\n");
+	unsigned int i;
+	u8 ch;
+	int ret;
 
 	mutex_lock(&ads114s0xb_priv->lock);
 
-	/* Find the first enabled channel */
-	for (i = 0; i < ads114s0xb_priv->chip_info->num_channels; i++) {
-		if (test_bit(i, scan_mask)) {
-			enabled_channel = i;
-			break;
+	/* Before the first entry overwrites them */
+	if (!ads114s0xb_priv->calib_restore) {
+		ret = ads114s0xb_read_regs(indio_dev, ADS114S0XB_REGADDR_OFCAL0,
+			ads114s0xb_priv->calib_saved, ADS114S0XB_CAL_REGS);
+		if (ret) {
+			mutex_unlock(&ads114s0xb_priv->lock);
+			return ret;
 		}
+		ads114s0xb_priv->calib_restore = true;
+	}
+
+	/* Precompute the conversion order for the trigger handler */
+	ads114s0xb_priv->scan_count = 0;
+	ads114s0xb_priv->calib_scan = false;
+	for_each_set_bit(i, scan_mask, ads114s0xb_priv->chip_info->num_channels) {
+		ads114s0xb_priv->scan_order[ads114s0xb_priv->scan_count++] = i;
+		if (test_bit(i, ads114s0xb_priv->calib_valid))
+			ads114s0xb_priv->calib_scan = true;
 	}
 
-	if (enabled_channel >= 0) {
-		ads114s0xb_write_reg(indio_dev, ADS114S0XB_REGADDR_INPMUX, 
-			enabled_channel);
+	if (ads114s0xb_priv->scan_count > 0) {
+		ch = ads114s0xb_priv->scan_order[0];
+		ads114s0xb_write_reg(indio_dev, ADS114S0XB_REGADDR_INPMUX, ch);
+		/* The messages only load the channels they switch to */
+		if (ads114s0xb_priv->calib_scan)
+			ads114s0xb_write_regs(indio_dev,
+				ADS114S0XB_REGADDR_OFCAL0,
+				test_bit(ch, ads114s0xb_priv->calib_valid) ?
+				ads114s0xb_priv->calib[ch] :
+				ads114s0xb_priv->calib_saved,
+				ADS114S0XB_CAL_REGS);
 		dev_info(&ads114s0xb_priv->spi->dev, 
-			"Enabled ADC channel %d\n", enabled_channel);
+			"Enabled %u ADC channel(s), first %d\n",
+			ads114s0xb_priv->scan_count,
+			ads114s0xb_priv->scan_order[0]);
 	} else {
 		ads114s0xb_write_reg(indio_dev, 
 			ADS114S0XB_REGADDR_INPMUX, 0x00); // Default
@@ -351,6 +883,9 @@ static int ads114s0xb_update_scan_mode(struct iio_dev *indio_dev,
 			"Set the default (0) channel\n");
 	}
 
+	/* Before the trigger is attached, which may fire right away */
+	ads114s0xb_prepare_messages(indio_dev);
+
 	mutex_unlock(&ads114s0xb_priv->lock);
 	return 0;
 }
@@ -359,23 +894,31 @@ static int ads114s0xb_update_scan_mode(struct iio_dev *indio_dev,
 static int ads114s0xb_reset(struct iio_dev *indio_dev)
 {
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	int ret;
 
 	if (ads114s0xb_priv->reset_gpio) {
 		gpiod_set_value_cansleep(ads114s0xb_priv->reset_gpio, 0);
 		udelay(100); // Setting 100x more.
 		gpiod_set_value_cansleep(ads114s0xb_priv->reset_gpio, 1);
 	} else {
-		return ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_RESET);
+		ret = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_RESET);
+		if (ret)
+			return ret;
 	}
 
-	return 0;
+	/* 4096 clock periods before the chip accepts commands again */
+	fsleep(1000);
+
+	/* Registers are back to power-on values, restore the cached ones */
+	regcache_mark_dirty(ads114s0xb_priv->regmap);
+	return regcache_sync(ads114s0xb_priv->regmap);
 };
 
 static int ads114s0xb_buffer_preenable(struct iio_dev *indio_dev)
 {
 	struct ads114s0xb_private *priv = iio_priv(indio_dev);
 
-	pr_err("ads114s0xb: Starting ADC Acquire\n");
+	dev_dbg(&indio_dev->dev, "Starting ADC acquisition\n");
 
 	/* Check if at least one channel is enabled */
 	if (bitmap_empty(indio_dev->active_scan_mask, indio_dev->masklength))
@@ -389,15 +932,54 @@ static int ads114s0xb_buffer_preenable(struct iio_dev *indio_dev)
 	return 0;
 }
 
+/*
+ * With the DRDY trigger the ADC free-runs in continuous-conversion mode
+ * and every DRDY edge delivers a result, so conversions are started once
+ * here instead of per trigger.
+ */
+static int ads114s0xb_buffer_postenable(struct iio_dev *indio_dev)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	int ret;
+
+	if (!ads114s0xb_using_drdy(indio_dev))
+		return 0;
+
+	mutex_lock(&priv->lock);
+	priv->scan_pos = 0;
+	ret = regmap_update_bits(priv->regmap, ADS114S0XB_REGADDR_DATARATE,
+		ADS114S0XB_DATARATE_MODE, 0);
+	if (ret == 0)
+		ret = ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_START);
+	mutex_unlock(&priv->lock);
+
+	return ret;
+}
+
 static int ads114s0xb_buffer_postdisable(struct iio_dev *indio_dev)
 {
 	struct ads114s0xb_private *priv = iio_priv(indio_dev);
 
-	pr_err("ads114s0xb: Stoping ADC Acquire\n");
+	dev_dbg(&indio_dev->dev, "Stopping ADC acquisition\n");
 
 	/* Stop ADC conversion when no channels are active */
 	mutex_lock(&priv->lock);
 	ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_STOP);
+	/* A scan still waiting for the next DRDY's message is dropped */
+	priv->scan_out_ready = false;
+	/*
+	 * The conversion messages switched INPMUX behind regmap's back, bring
+	 * the chip back to the cached value (the first channel)
+	 */
+	if (priv->scan_count > 1)
+		ads114s0xb_write_reg(indio_dev, ADS114S0XB_REGADDR_INPMUX,
+			priv->scan_order[0]);
+	/* OFCAL/FSCAL as before the calibration entries, chip and cache */
+	if (priv->calib_restore) {
+		ads114s0xb_write_regs(indio_dev, ADS114S0XB_REGADDR_OFCAL0,
+			priv->calib_saved, ADS114S0XB_CAL_REGS);
+		priv->calib_restore = false;
+	}
 	mutex_unlock(&priv->lock);
 
 	return 0;
@@ -424,6 +1006,7 @@ IIO_RW_ATTRIBUTE(FSCAL1, ADS114S0XB_REGADDR_FSCAL1);
 IIO_RW_ATTRIBUTE(GPIODAT, ADS114S0XB_REGADDR_GPIODAT);
 IIO_RW_ATTRIBUTE(GPIOCON, ADS114S0XB_REGADDR_GPIOCON);
 IIO_RW_ATTRIBUTE(SENSOR_MOCK_MODE, ADS114S0XB_REGADDR_MOCK);
+static IIO_DEVICE_ATTR(calibrate, 0220, NULL, ads114s0xb_calibrate_store, 0);
 
 static struct attribute* ads114s0xb_attrs[] = {
 	&iio_dev_attr_ID.dev_attr.attr,
@@ -443,6 +1026,7 @@ static struct attribute* ads114s0xb_attrs[] = {
 	&iio_dev_attr_GPIODAT.dev_attr.attr,
 	&iio_dev_attr_GPIOCON.dev_attr.attr,
 	&iio_dev_attr_SENSOR_MOCK_MODE.dev_attr.attr,
+	&iio_dev_attr_calibrate.dev_attr.attr,
 	NULL,
 };
 
@@ -450,41 +1034,638 @@ static const struct attribute_group ads114s0xb_attr_group = {
 	.attrs = ads114s0xb_attrs,
 };
 
+/*
+ * "registers": the whole 0x00-0x11 register map as a binary file. The file
+ * offset is the register address, so a pwrite() of PGA..VBIAS at offset
+ * 0x03 reconfigures the channel with one SPI transfer.
+ */
+static ssize_t ads114s0xb_registers_read(struct file *filp,
+	struct kobject *kobj, struct bin_attribute *attr, char *buf,
+	loff_t off, size_t count)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(kobj_to_dev(kobj));
+	int ret;
+
+	if (off >= ADS114S0XB_NUM_REGS)
+		return 0;
+	count = min_t(size_t, count, ADS114S0XB_NUM_REGS - off);
+
+	ret = ads114s0xb_read_regs(indio_dev, off, buf, count);
+
+	return ret < 0 ? ret : count;
+}
+
+static ssize_t ads114s0xb_registers_write(struct file *filp,
+	struct kobject *kobj, struct bin_attribute *attr, char *buf,
+	loff_t off, size_t count)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(kobj_to_dev(kobj));
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	loff_t reg;
+	int ret;
+
+	if (off >= ADS114S0XB_NUM_REGS)
+		return -EFBIG;
+	count = min_t(size_t, count, ADS114S0XB_NUM_REGS - off);
+
+	/* A whole-map write must not put garbage into the reserved registers */
+	for (reg = off; reg < off + count; reg++)
+		if (reg == 0x0a || reg == 0x0d)
+			buf[reg - off] = 0;
+
+	/* Between two scans, never in the middle of one */
+	mutex_lock(&priv->lock);
+	ret = ads114s0xb_write_regs(indio_dev, off, buf, count);
+	if (off <= ADS114S0XB_REGADDR_DATARATE &&
+	    off + count > ADS114S0XB_REGADDR_PGA)
+		ads114s0xb_rate_update(priv);
+	mutex_unlock(&priv->lock);
+
+	return ret < 0 ? ret : count;
+}
+
+static BIN_ATTR(registers, 0664, ads114s0xb_registers_read,
+	ads114s0xb_registers_write, ADS114S0XB_NUM_REGS);
+
+/*
+ * "calibration": OFCAL0..FSCAL1 (5 bytes, the reserved 0x0d included) of
+ * every channel, at offset channel * 5, e.g. the words a "calibrate" run
+ * left in the registers. A buffered scan loads a channel's entry once it
+ * has been written, with the WREG in the same SPI message that selects
+ * the channel, so a scan over channels with different calibrations costs
+ * no extra round trip. Writes cover whole entries; writing the reset
+ * words removes an entry. Taken into account at the next buffer enable.
+ */
+static ssize_t ads114s0xb_calibration_size(struct ads114s0xb_private *priv)
+{
+	return priv->chip_info->num_channels * ADS114S0XB_CAL_REGS;
+}
+
+static ssize_t ads114s0xb_calibration_read(struct file *filp,
+	struct kobject *kobj, struct bin_attribute *attr, char *buf,
+	loff_t off, size_t count)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(kobj_to_dev(kobj));
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	ssize_t size = ads114s0xb_calibration_size(priv);
+
+	if (off >= size)
+		return 0;
+	count = min_t(size_t, count, size - off);
+
+	mutex_lock(&priv->lock);
+	memcpy(buf, (u8 *)priv->calib + off, count);
+	mutex_unlock(&priv->lock);
+
+	return count;
+}
+
+static ssize_t ads114s0xb_calibration_write(struct file *filp,
+	struct kobject *kobj, struct bin_attribute *attr, char *buf,
+	loff_t off, size_t count)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(kobj_to_dev(kobj));
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	ssize_t size = ads114s0xb_calibration_size(priv);
+	unsigned int ch;
+
+	if (off >= size)
+		return -EFBIG;
+	/* Half an entry would leave FSCAL at whatever was there */
+	if (off % ADS114S0XB_CAL_REGS || count % ADS114S0XB_CAL_REGS)
+		return -EINVAL;
+	count = min_t(size_t, count, size - off);
+
+	mutex_lock(&priv->lock);
+	memcpy((u8 *)priv->calib + off, buf, count);
+	for (ch = off / ADS114S0XB_CAL_REGS;
+	     ch < (off + count) / ADS114S0XB_CAL_REGS; ch++) {
+		/* 0x0d is reserved and has to stay 0 */
+		priv->calib[ch][0x0d - ADS114S0XB_REGADDR_OFCAL0] = 0;
+		if (memcmp(priv->calib[ch], ads114s0xb_cal_reset,
+			   ADS114S0XB_CAL_REGS))
+			set_bit(ch, priv->calib_valid);
+		else
+			clear_bit(ch, priv->calib_valid);
+	}
+	mutex_unlock(&priv->lock);
+
+	return count;
+}
+
+static BIN_ATTR(calibration, 0664, ads114s0xb_calibration_read,
+	ads114s0xb_calibration_write,
+	ADS114S0XB_MAX_CHANNELS * ADS114S0XB_CAL_REGS);
+
+static void ads114s0xb_remove_bin_files(void *data)
+{
+	struct iio_dev *indio_dev = data;
+
+	device_remove_bin_file(&indio_dev->dev, &bin_attr_calibration);
+	device_remove_bin_file(&indio_dev->dev, &bin_attr_registers);
+}
+
+/*
+ * Also what makes the IIO core create the device's debugfs directory,
+ * /sys/kernel/debug/iio/iio:deviceN, where "stats" lives next to
+ * direct_reg_access. Serialized like the other register paths; writes
+ * return -EBUSY while the buffer is enabled, since the conversion
+ * messages switch INPMUX and OFCAL/FSCAL behind regmap's back.
+ */
+static int ads114s0xb_debugfs_reg_access(struct iio_dev *indio_dev,
+	unsigned int reg, unsigned int writeval, unsigned int *readval)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	int ret;
+
+	if (readval) {
+		mutex_lock(&priv->lock);
+		ret = regmap_read(priv->regmap, reg, readval);
+		mutex_unlock(&priv->lock);
+		return ret;
+	}
+
+	ret = iio_device_claim_direct_mode(indio_dev);
+	if (ret)
+		return ret;
+
+	mutex_lock(&priv->lock);
+	ret = regmap_write(priv->regmap, reg, writeval);
+	mutex_unlock(&priv->lock);
+	iio_device_release_direct_mode(indio_dev);
+
+	return ret;
+}
+
+static int ads114s0xb_stats_show(struct seq_file *s, void *unused)
+{
+	struct iio_dev *indio_dev = s->private;
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	struct ads114s0xb_stats stats;
+
+	mutex_lock(&priv->lock);
+	stats = priv->stats;
+	mutex_unlock(&priv->lock);
+
+	seq_printf(s, "triggers: %llu\n", stats.triggers);
+	seq_printf(s, "conversions: %llu\n", stats.conversions);
+	seq_printf(s, "scans: %llu\n", stats.scans);
+	seq_printf(s, "spi_errors: %llu\n", stats.spi_errors);
+	seq_printf(s, "push_errors: %llu\n", stats.push_errors);
+	seq_printf(s, "latency_min_ns: %llu\n", stats.latency_min_ns);
+	seq_printf(s, "latency_avg_ns: %llu\n", stats.triggers ?
+		div64_u64(stats.latency_sum_ns, stats.triggers) : 0);
+	seq_printf(s, "latency_max_ns: %llu\n", stats.latency_max_ns);
+
+	return 0;
+}
+
+static int ads114s0xb_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ads114s0xb_stats_show, inode->i_private);
+}
+
+/* Any write starts the counters over */
+static ssize_t ads114s0xb_stats_write(struct file *file,
+	const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct ads114s0xb_private *priv = iio_priv(s->private);
+
+	mutex_lock(&priv->lock);
+	memset(&priv->stats, 0, sizeof(priv->stats));
+	mutex_unlock(&priv->lock);
+
+	return count;
+}
+
+static const struct file_operations ads114s0xb_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = ads114s0xb_stats_open,
+	.read = seq_read,
+	.write = ads114s0xb_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* Removed with the directory when the IIO device is unregistered */
+static void ads114s0xb_debugfs_init(struct iio_dev *indio_dev)
+{
+	struct dentry *dir = iio_get_debugfs_dentry(indio_dev);
+
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("stats", 0644, dir, indio_dev,
+		&ads114s0xb_stats_fops);
+}
+
 static const struct iio_info ads114s0xb_info = {
 	.read_raw = ads114s0xb_read_raw,
 	.attrs = &ads114s0xb_attr_group,
 	.update_scan_mode = ads114s0xb_update_scan_mode,
+	.debugfs_reg_access = ads114s0xb_debugfs_reg_access,
 };
 
-// Simulated sensor raw values
+/* Called with priv->lock held */
+static void ads114s0xb_push_scan(struct iio_dev *indio_dev,
+	struct ads114s0xb_scan *scan, s64 timestamp)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	int ret;
+
+	ret = iio_push_to_buffers_with_timestamp(indio_dev, scan, timestamp);
+	if (ret < 0)
+		priv->stats.push_errors++; /* -EBUSY when the kfifo is full */
+	else
+		priv->stats.scans++;
+	trace_ads114s0xb_push(dev_name(&indio_dev->dev), timestamp, ret);
+}
+
+static void ads114s0xb_conv_complete(void *context)
+{
+	complete(context);
+}
+
+/*
+ * Runs pre-built message pos. With conv_async the scan finished by the
+ * previous DRDY is pushed while the message is on the bus.
+ */
+static int ads114s0xb_conv_run(struct iio_dev *indio_dev, unsigned int pos)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	struct spi_message *msg = &priv->conv_msg[pos];
+	u64 start = 0;
+	int ret;
+
+	if (trace_ads114s0xb_spi_read_enabled())
+		start = ktime_get_ns();
+
+	if (priv->conv_async) {
+		reinit_completion(&priv->conv_done);
+		msg->complete = ads114s0xb_conv_complete;
+		msg->context = &priv->conv_done;
+		ret = spi_async(priv->spi, msg);
+		if (ret == 0) {
+			if (priv->scan_out_ready) {
+				ads114s0xb_push_scan(indio_dev, &priv->scan_out,
+					priv->scan_out_timestamp);
+				priv->scan_out_ready = false;
+			}
+			wait_for_completion(&priv->conv_done);
+			ret = msg->status;
+		}
+	} else {
+		ret = spi_sync(priv->spi, msg);
+	}
+
+	trace_ads114s0xb_spi_read(dev_name(&indio_dev->dev),
+		start ? ktime_get_ns() - start : 0, ret);
+	if (ret < 0)
+		priv->stats.spi_errors++;
+
+	return ret;
+}
+
+/* Result of the conversion read back by the last message, position pos */
+static s16 ads114s0xb_conv_result(struct ads114s0xb_private *priv,
+	unsigned int pos)
+{
+	priv->stats.conversions++;
+
+	/* In mock mode this is the mock counter */
+	return ads114s0xb_result(priv, &priv->conv_buf.rx[pos][1]);
+}
+
+/*
+ * External trigger: one trigger converts every enabled channel in
+ * scan_order, one pre-built message per conversion (the mux switch and
+ * START of the next channel travel with the readback of the previous
+ * one), and the whole scan is pushed once with its timestamp.
+ */
+static void ads114s0xb_scan_read(struct iio_dev *indio_dev, s64 timestamp)
+{
+	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	unsigned int i;
+
+	if (ads114s0xb_conv_run(indio_dev, 0) < 0)
+		return;
+
+	for (i = 0; i < ads114s0xb_priv->scan_count; i++) {
+		ads114s0xb_wait_conversion(indio_dev, false);
+		if (ads114s0xb_conv_run(indio_dev, i + 1) < 0)
+			return;
+		ads114s0xb_priv->scan.samples[i] =
+			ads114s0xb_conv_result(ads114s0xb_priv, i);
+	}
+
+	ads114s0xb_push_scan(indio_dev, &ads114s0xb_priv->scan, timestamp);
+}
+
+/*
+ * DRDY trigger: the ADC is free-running, so each DRDY is the result for
+ * scan_order[scan_pos]. Its message also switches INPMUX, which restarts
+ * conversion on the next channel, and the scan is pushed once its last
+ * channel has been read (with async_spi, during the next DRDY's message).
+ */
+static void ads114s0xb_drdy_read(struct iio_dev *indio_dev, s64 timestamp)
+{
+	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	unsigned int pos = ads114s0xb_priv->scan_pos;
+
+	if (ads114s0xb_conv_run(indio_dev, pos) < 0)
+		return;
+
+	ads114s0xb_priv->scan.samples[pos] =
+		ads114s0xb_conv_result(ads114s0xb_priv, pos);
+	if (++ads114s0xb_priv->scan_pos < ads114s0xb_priv->scan_count)
+		return;
+
+	ads114s0xb_priv->scan_pos = 0;
+	if (ads114s0xb_priv->conv_async) {
+		ads114s0xb_priv->scan_out = ads114s0xb_priv->scan;
+		ads114s0xb_priv->scan_out_timestamp = timestamp;
+		ads114s0xb_priv->scan_out_ready = true;
+	} else {
+		ads114s0xb_push_scan(indio_dev, &ads114s0xb_priv->scan,
+			timestamp);
+	}
+}
+
 static irqreturn_t ads114s0xb_trigger_handler(int irq, void *private) {
 	struct iio_poll_func *pf = private;
 	struct iio_dev *indio_dev = pf->indio_dev;
 	struct ads114s0xb_private *ads114s0xb_priv = iio_priv(indio_dev);
+	struct ads114s0xb_stats *stats = &ads114s0xb_priv->stats;
+	bool drdy = ads114s0xb_using_drdy(indio_dev);
+	u64 latency;
 
-	pr_info("ads114s0xb_trigger_handler: Called");
+	mutex_lock(&ads114s0xb_priv->lock);
+	trace_ads114s0xb_trigger(dev_name(&indio_dev->dev), pf->timestamp,
+		ads114s0xb_priv->scan_count, drdy);
+	if (drdy)
+		ads114s0xb_drdy_read(indio_dev, pf->timestamp);
+	else
+		ads114s0xb_scan_read(indio_dev, pf->timestamp);
+
+	/* Same clock as pf->timestamp, see iio_pollfunc_store_time() */
+	latency = max_t(s64, iio_get_time_ns(indio_dev) - pf->timestamp, 0);
+	if (stats->triggers == 0 || latency < stats->latency_min_ns)
+		stats->latency_min_ns = latency;
+	if (latency > stats->latency_max_ns)
+		stats->latency_max_ns = latency;
+	stats->latency_sum_ns += latency;
+	stats->triggers++;
+	mutex_unlock(&ads114s0xb_priv->lock);
 
-	ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_START);
-	
-	ads114s0xb_priv->buffer[0] = ads114s0xb_read(indio_dev);
-	// Mock
-	if (ads114s0xb_priv->mock_flag != 0) {
-		memcpy(&ads114s0xb_priv->buffer[0],
-			&ads114s0xb_priv->mock_data,
-			sizeof ads114s0xb_priv->mock_data);
-		ads114s0xb_priv->mock_data++;
-	}
+	iio_trigger_notify_done(indio_dev->trig);
+	return IRQ_HANDLED;
+}
 
-	ads114s0xb_write_cmd(indio_dev, ADS114S0XB_CMD_STOP);
+/* DRDY edge: feeds the trigger while buffered, a direct read otherwise */
+static irqreturn_t ads114s0xb_drdy_irq(int irq, void *private)
+{
+	struct iio_dev *indio_dev = private;
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	if (iio_buffer_enabled(indio_dev))
+		iio_trigger_poll(priv->drdy_trig);
+	else
+		complete(&priv->drdy_done);
 
-	iio_push_to_buffers_with_timestamp(indio_dev, ads114s0xb_priv->buffer, 
-		iio_get_time_ns(indio_dev));
-	iio_trigger_notify_done(indio_dev->trig);
 	return IRQ_HANDLED;
 }
 
+/*
+ * Period of the software DRDY. Each INPMUX switch of a multi-channel scan
+ * restarts the conversion, with the PGA start delay and the filter
+ * settling, so every result takes the full conversion time; only a single
+ * channel converts at the raw data rate once settled.
+ */
+static u64 ads114s0xb_drdy_period_ns(struct ads114s0xb_private *priv)
+{
+	unsigned int datarate = ADS114S0XB_DATARATE_DEFAULT;
+
+	if (priv->scan_count > 1)
+		return (u64)ads114s0xb_conversion_time_us(priv) * NSEC_PER_USEC;
+
+	regmap_read(priv->regmap, ADS114S0XB_REGADDR_DATARATE, &datarate);
+
+	return div_u64(1000000000000ULL, ads114s0xb_data_rates_msps[
+		datarate & ADS114S0XB_DATARATE_DR_MASK]);
+}
+
+/*
+ * Software DRDY: fires once per result. Runs in hard irq context, which
+ * iio_trigger_poll() needs, also on PREEMPT_RT.
+ */
+static enum hrtimer_restart ads114s0xb_drdy_timer_fn(struct hrtimer *timer)
+{
+	struct ads114s0xb_private *priv =
+		container_of(timer, struct ads114s0xb_private, drdy_timer);
+
+	iio_trigger_poll(priv->drdy_trig);
+	hrtimer_forward_now(timer, ns_to_ktime(priv->drdy_period_ns));
+
+	return HRTIMER_RESTART;
+}
+
+/*
+ * The real DRDY line is used when the device tree provides an interrupt
+ * and SENSOR_MOCK_MODE is off; otherwise DRDY is emulated by an hrtimer.
+ */
+static int ads114s0xb_drdy_set_state(struct iio_trigger *trig, bool state)
+{
+	struct iio_dev *indio_dev = iio_trigger_get_drvdata(trig);
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	if (state) {
+		priv->drdy_emulated = priv->drdy_irq <= 0 || priv->mock_flag;
+		if (priv->drdy_emulated) {
+			/* Computed here, the timer callback cannot sleep */
+			priv->drdy_period_ns = ads114s0xb_drdy_period_ns(priv);
+			/* The first result after START needs to settle */
+			hrtimer_start(&priv->drdy_timer,
+				ns_to_ktime(max_t(u64, priv->drdy_period_ns,
+					(u64)ads114s0xb_conversion_time_us(priv) *
+					NSEC_PER_USEC)),
+				HRTIMER_MODE_REL_HARD);
+		}
+		else
+			enable_irq(priv->drdy_irq);
+	} else {
+		if (priv->drdy_emulated)
+			hrtimer_cancel(&priv->drdy_timer);
+		else
+			disable_irq(priv->drdy_irq);
+	}
+
+	return 0;
+}
+
+static const struct iio_trigger_ops ads114s0xb_drdy_trigger_ops = {
+	.set_trigger_state = ads114s0xb_drdy_set_state,
+	.validate_device = iio_trigger_validate_own_device,
+};
+
+static int ads114s0xb_setup_drdy_trigger(struct iio_dev *indio_dev)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	struct device *dev = &priv->spi->dev;
+	int ret;
+
+	priv->drdy_trig = devm_iio_trigger_alloc(dev, "%s-dev%d-drdy",
+		indio_dev->name, iio_device_id(indio_dev));
+	if (!priv->drdy_trig)
+		return -ENOMEM;
+
+	priv->drdy_trig->ops = &ads114s0xb_drdy_trigger_ops;
+	iio_trigger_set_drvdata(priv->drdy_trig, indio_dev);
+
+	hrtimer_init(&priv->drdy_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	priv->drdy_timer.function = ads114s0xb_drdy_timer_fn;
+
+	priv->drdy_irq = priv->spi->irq;
+	if (priv->drdy_irq > 0) {
+		ret = devm_request_irq(dev, priv->drdy_irq,
+			ads114s0xb_drdy_irq, IRQF_NO_AUTOEN,
+			indio_dev->name, indio_dev);
+		if (ret) {
+			dev_err(dev, "DRDY irq request failed\n");
+			return ret;
+		}
+	} else {
+		dev_info(dev, "DRDY interrupt not defined, emulating DRDY\n");
+	}
+
+	ret = devm_iio_trigger_register(dev, priv->drdy_trig);
+	if (ret)
+		return ret;
+
+	/* Use DRDY by default when the line is actually wired */
+	if (priv->drdy_irq > 0)
+		indio_dev->trig = iio_trigger_get(priv->drdy_trig);
+
+	return 0;
+}
+
+/*
+ * Timer trigger: scans at sampling_frequency, paced by an hrtimer instead
+ * of user-space trigger_now writes. Works the same in SENSOR_MOCK_MODE.
+ */
+static ssize_t ads114s0xb_rate_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct iio_dev *indio_dev = iio_trigger_get_drvdata(to_iio_trigger(dev));
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	unsigned int mhz;
+
+	mutex_lock(&priv->lock);
+	mhz = ads114s0xb_rate_mhz(priv);
+	mutex_unlock(&priv->lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%u.%03u\n", mhz / 1000, mhz % 1000);
+}
+
+/* Takes effect immediately when the trigger is running */
+static ssize_t ads114s0xb_rate_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct iio_dev *indio_dev = iio_trigger_get_drvdata(to_iio_trigger(dev));
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	int integer, fract, ret;
+
+	ret = iio_str_to_fixpoint(buf, 100, &integer, &fract);
+	if (ret)
+		return ret;
+	if (integer < 0 || fract < 0 || (integer == 0 && fract == 0))
+		return -EINVAL;
+
+	mutex_lock(&priv->lock);
+	priv->rate_mhz = min_t(u64, (u64)integer * 1000 + fract, UINT_MAX);
+	ads114s0xb_rate_update(priv);
+	mutex_unlock(&priv->lock);
+
+	return count;
+}
+
+static DEVICE_ATTR(sampling_frequency, 0664, ads114s0xb_rate_show,
+	ads114s0xb_rate_store);
+
+static struct attribute *ads114s0xb_rate_attrs[] = {
+	&dev_attr_sampling_frequency.attr,
+	NULL,
+};
+
+static const struct attribute_group ads114s0xb_rate_attr_group = {
+	.attrs = ads114s0xb_rate_attrs,
+};
+
+static const struct attribute_group *ads114s0xb_rate_attr_groups[] = {
+	&ads114s0xb_rate_attr_group,
+	NULL,
+};
+
+/* Forwarded on the absolute grid, so a late callback does not shift the next */
+static enum hrtimer_restart ads114s0xb_rate_timer_fn(struct hrtimer *timer)
+{
+	struct ads114s0xb_private *priv =
+		container_of(timer, struct ads114s0xb_private, rate_timer);
+
+	iio_trigger_poll(priv->rate_trig);
+	hrtimer_forward_now(timer, ns_to_ktime(READ_ONCE(priv->rate_period_ns)));
+
+	return HRTIMER_RESTART;
+}
+
+/* Runs after update_scan_mode, so the clamp sees the enabled channels */
+static int ads114s0xb_rate_set_state(struct iio_trigger *trig, bool state)
+{
+	struct iio_dev *indio_dev = iio_trigger_get_drvdata(trig);
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+
+	if (state) {
+		mutex_lock(&priv->lock);
+		ads114s0xb_rate_update(priv);
+		mutex_unlock(&priv->lock);
+		hrtimer_start(&priv->rate_timer,
+			ns_to_ktime(priv->rate_period_ns), HRTIMER_MODE_REL_HARD);
+	} else {
+		hrtimer_cancel(&priv->rate_timer);
+	}
+
+	return 0;
+}
+
+static const struct iio_trigger_ops ads114s0xb_rate_trigger_ops = {
+	.set_trigger_state = ads114s0xb_rate_set_state,
+	.validate_device = iio_trigger_validate_own_device,
+};
+
+static int ads114s0xb_setup_rate_trigger(struct iio_dev *indio_dev)
+{
+	struct ads114s0xb_private *priv = iio_priv(indio_dev);
+	struct device *dev = &priv->spi->dev;
+
+	priv->rate_trig = devm_iio_trigger_alloc(dev, "%s-dev%d-timer",
+		indio_dev->name, iio_device_id(indio_dev));
+	if (!priv->rate_trig)
+		return -ENOMEM;
+
+	priv->rate_trig->ops = &ads114s0xb_rate_trigger_ops;
+	priv->rate_trig->dev.groups = ads114s0xb_rate_attr_groups;
+	iio_trigger_set_drvdata(priv->rate_trig, indio_dev);
+
+	priv->rate_mhz = ADS114S0XB_RATE_DEFAULT_MHZ;
+	hrtimer_init(&priv->rate_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	priv->rate_timer.function = ads114s0xb_rate_timer_fn;
+
+	return devm_iio_trigger_register(dev, priv->rate_trig);
+}
+
 static const struct iio_buffer_setup_ops ads114s0xb_buffer_ops = {
 	.preenable = ads114s0xb_buffer_preenable,
+	.postenable = ads114s0xb_buffer_postenable,
 	.postdisable = ads114s0xb_buffer_postdisable,
 };
 
@@ -493,6 +1674,7 @@ static int ads114s0xb_probe(struct spi_device *spi)
 {
 	struct ads114s0xb_private *ads114s0xb_priv;
 	struct iio_dev *indio_dev;
+	unsigned int i;
 	int ret;
 	const struct spi_device_id *spi_id = spi_get_device_id(spi);
 
@@ -508,6 +1690,11 @@ static int ads114s0xb_probe(struct spi_device *spi)
 	ads114s0xb_priv = iio_priv(indio_dev);
 	ads114s0xb_priv->mock_flag = 0;
 	ads114s0xb_priv->mock_data = 0;
+	for (i = 0; i < ADS114S0XB_MAX_CHANNELS; i++)
+		memcpy(ads114s0xb_priv->calib[i], ads114s0xb_cal_reset,
+			ADS114S0XB_CAL_REGS);
+	init_completion(&ads114s0xb_priv->drdy_done);
+	init_completion(&ads114s0xb_priv->conv_done);
 	ads114s0xb_priv->spi = spi;
 	ads114s0xb_priv->chip_info = 
 		&ads114s0xb_chip_info_tbl[spi_id->driver_data];
@@ -518,19 +1705,41 @@ static int ads114s0xb_probe(struct spi_device *spi)
 
 	mutex_init(&ads114s0xb_priv->lock);
 
+	ads114s0xb_priv->regmap = devm_regmap_init(&spi->dev,
+		&ads114s0xb_regmap_bus, ads114s0xb_priv,
+		&ads114s0xb_regmap_config);
+	if (IS_ERR(ads114s0xb_priv->regmap)) {
+		dev_err(&spi->dev, "regmap init failed\n");
+		return PTR_ERR(ads114s0xb_priv->regmap);
+	}
+
 	indio_dev->info = &ads114s0xb_info;
 	indio_dev->name = spi_id->name;
 	indio_dev->modes = INDIO_DIRECT_MODE | INDIO_BUFFER_TRIGGERED;
 
 	indio_dev->channels = ads114s0xb_priv->chip_info->channels;
-	indio_dev->num_channels = ads114s0xb_priv->chip_info->num_channels;
+	/* Analog inputs plus the soft timestamp channel */
+	indio_dev->num_channels = ads114s0xb_priv->chip_info->num_channels + 1;
 
-	ret = devm_iio_triggered_buffer_setup(&spi->dev, indio_dev, NULL,
-		ads114s0xb_trigger_handler, NULL);
+	ret = devm_iio_triggered_buffer_setup(&spi->dev, indio_dev,
+		iio_pollfunc_store_time, ads114s0xb_trigger_handler,
+		&ads114s0xb_buffer_ops);
 	if (ret) {
 		dev_err(&spi->dev, "iio triggered buffer setup failed\n");
 		return ret;
 	}
+
+	ret = ads114s0xb_setup_drdy_trigger(indio_dev);
+	if (ret) {
+		dev_err(&spi->dev, "DRDY trigger setup failed\n");
+		return ret;
+	}
+
+	ret = ads114s0xb_setup_rate_trigger(indio_dev);
+	if (ret) {
+		dev_err(&spi->dev, "timer trigger setup failed\n");
+		return ret;
+	}
 	
 	/* Register IIO device */
 	ret = devm_iio_device_register(&spi->dev, indio_dev);
@@ -539,6 +1748,25 @@ static int ads114s0xb_probe(struct spi_device *spi)
 		return ret;
 	}
 
+	/* The IIO core only publishes plain attributes from iio_info */
+	ret = device_create_bin_file(&indio_dev->dev, &bin_attr_registers);
+	if (ret) {
+		dev_err(&spi->dev, "registers file creation failed\n");
+		return ret;
+	}
+	ret = device_create_bin_file(&indio_dev->dev, &bin_attr_calibration);
+	if (ret) {
+		dev_err(&spi->dev, "calibration file creation failed\n");
+		device_remove_bin_file(&indio_dev->dev, &bin_attr_registers);
+		return ret;
+	}
+	ret = devm_add_action_or_reset(&spi->dev,
+		ads114s0xb_remove_bin_files, indio_dev);
+	if (ret)
+		return ret;
+
+	ads114s0xb_debugfs_init(indio_dev);
+
 	spi_set_drvdata(spi, indio_dev);
 	pr_info("ads114s0xb: SPI driver successfully registered\n");
 
@@ -7,88 +7,73 @@
 #include <thread>
 #include <chrono>
 #include <string>
-#include <unordered_map>
+#include <array>
+#include <algorithm>
+#include <string_view>
 #include <optional>
+#include <span>
+#include <memory>
 
+#include "ADS114S0XBRegisters.h"
+#include "AdcBackend.h"
+#include "AsyncSession.h"
+#include "CaptureFile.h"
 #include "IIOSysfsFilesUtil.h"
+#include "IioBufferAcquisition.h"
+#include "LibiioBackend.h"
+#include "Metrics.h"
+#include "StreamingSession.h"
+#include "VoltageConverter.h"
 
 namespace adcs
 {
+// The chip's calibration commands, see ADS114S0XB::calibrate().
+enum class CalibrationCommand {
+    SystemOffset, // SYOCAL, zero input applied by the system
+    SystemGain,   // SYGCAL, full-scale input applied by the system
+    SelfOffset,   // SFOCAL, inputs shorted internally
+};
+
 class ADS114S0XB {
 public:
-    enum class ADS114S0XBRegister {
-        DATARATE,
-        FSCAL0,
-        FSCAL1,
-        GPIOCON,
-        GPIODAT,
-        ID,
-        IDACMAG,
-        IDACMUX,
-        INPMUX,
-        OFCAL0,
-        OFCAL1,
-        PGA,
-        REF,
-        STATUS,
-        SYS,
-        VBIAS,
-        SENSOR_MOCK_MODE,
-        COUNT, //Sentinel Value
-    };
-
-    const std::unordered_map<ADS114S0XBRegister, std::string> registerMap = {
-        {ADS114S0XBRegister::DATARATE, "DATARATE"},
-        {ADS114S0XBRegister::FSCAL0, "FSCAL0"},
-        {ADS114S0XBRegister::FSCAL1, "FSCAL1"},
-        {ADS114S0XBRegister::GPIOCON, "GPIOCON"},
-        {ADS114S0XBRegister::GPIODAT, "GPIODAT"},
-        {ADS114S0XBRegister::ID, "ID"},
-        {ADS114S0XBRegister::IDACMAG, "IDACMAG"},
-        {ADS114S0XBRegister::IDACMUX, "IDACMUX"},
-        {ADS114S0XBRegister::INPMUX, "INPMUX"},
-        {ADS114S0XBRegister::OFCAL0, "OFCAL0"},
-        {ADS114S0XBRegister::OFCAL1, "OFCAL1"},
-        {ADS114S0XBRegister::PGA, "PGA"},
-        {ADS114S0XBRegister::REF, "REF"},
-        {ADS114S0XBRegister::STATUS, "STATUS"},
-        {ADS114S0XBRegister::SYS, "SYS"},
-        {ADS114S0XBRegister::VBIAS, "VBIAS"},
-        {ADS114S0XBRegister::SENSOR_MOCK_MODE, "SENSOR_MOCK_MODE"},
-    };
-    ADS114S0XB() {
+    using ADS114S0XBRegister = adcs::ADS114S0XBRegister;
+
+    // Register id and sysfs name pairs, built at compile time from
+    // REGISTER_DESCRIPTORS (no hashing on the control path).
+    static constexpr auto registerMap = [] {
+        std::array<std::pair<ADS114S0XBRegister, std::string_view>, REGISTER_DESCRIPTORS.size()> map{};
+        for (size_t i = 0; i < map.size(); i++) {
+            map[i] = {REGISTER_DESCRIPTORS[i].id, REGISTER_DESCRIPTORS[i].name};
+        }
+        return map;
+    }();
+
+    ADS114S0XB() :
+        _backend(std::make_unique<LibiioBackend>(_iioSysfs)) {
+    }
+    explicit ADS114S0XB(const IIOSysfsFilesUtil &iioSysfs) :
+        _iioSysfs(iioSysfs),
+        _backend(std::make_unique<LibiioBackend>(_iioSysfs)) {
+    }
+    // Any other backend, e.g. a SimulatedBackend for machines without the
+    // chip. iioSysfs locates the files used by triggerConversion(),
+    // readBuffer() and createStreamingSession(), which only exist for the
+    // kernel driver (or a fake tree standing in for it).
+    explicit ADS114S0XB(std::unique_ptr<AdcBackend> backend,
+            const IIOSysfsFilesUtil &iioSysfs = IIOSysfsFilesUtil()) :
+        _iioSysfs(iioSysfs),
+        _backend(std::move(backend)) {
     }
     // Prefer to use something similar to StatusOr<T> as a return
     // https://cloud.google.com/cpp/docs/reference/common/latest/classgoogle_1_1cloud_1_1StatusOr
     std::pair<int, std::string> initialize() {
-        if (_ctx != nullptr) {
-            return {0, "already initialized"};
-        }
-        _ctx = iio_create_default_context();
-        if (!_ctx) {
-            return {errno, "iio_create_default_context"};
-        }
-
-        _dev = iio_context_find_device(_ctx, _iioSysfs.getIIODeviceName().c_str());
-        if (!_dev) {
-            iio_context_destroy(_ctx);
-            _ctx = nullptr;
-            return {errno, "iio_create_default_context"};
-        }
-
-        _trigger = iio_context_find_device(_ctx, _iioSysfs.getTriggerInstance().c_str());
-        if (!_trigger) {
-            iio_context_destroy(_ctx);
-            _ctx = nullptr;
-            return {errno, "iio_create_default_context, trigger"};
-        }
-        return {0,""};
+        return _backend->open();
     }
 
-    ~ADS114S0XB() {
-        if (_ctx != nullptr) {
-            iio_context_destroy(_ctx);
-        }
+    // Same as initialize(), on a libiio URI such as "ip:localhost" (iiod)
+    // or "xml:ads114s08b.xml".
+    std::pair<int, std::string> initialize(const std::string &uri) {
+        return _backend->open(uri);
     }
     static constexpr std::string _in_voltage_x_en{};
     void setChannel(int channel) {
@@ -96,17 +81,23 @@ public:
         setAttribute(
             _iioSysfs.getVoltageEnable(channel), 
             _iioSysfs.getFlagOn());
+        if (std::find(_channels.begin(), _channels.end(), channel) == _channels.end()) {
+            _channels.insert(std::upper_bound(_channels.begin(), _channels.end(), channel), channel);
+        }
     }
     void resetChannel(int channel) {
         disableBuffer();
         setAttribute(
             _iioSysfs.getVoltageEnable(channel), 
             _iioSysfs.getFlagOff());
-
+        _channels.erase(std::remove(_channels.begin(), _channels.end(), channel), _channels.end());
     }
     
     
+    // The scan layout is fixed while the buffer is enabled, so it is read
+    // from scan_elements/ here once rather than per read.
     void enableBuffer() {
+        _scanLayout = _backend->scanLayout();
         setAttribute(_iioSysfs.getBufferEnable(), _iioSysfs.getFlagOn());
     }
 
@@ -114,6 +105,31 @@ public:
         setAttribute(_iioSysfs.getBufferEnable(), _iioSysfs.getFlagOff());
     }
 
+    // Capacity of the kernel buffer (kfifo) in scans. The IIO core only
+    // takes it while the buffer is disabled, so this disables it.
+    bool setBufferLength(size_t scans) {
+        disableBuffer();
+        return _backend->writeAttributeValue(_iioSysfs.getBufferLength(), static_cast<long long>(scans));
+    }
+
+    std::optional<size_t> getBufferLength() {
+        auto value = _backend->readAttributeValue(_iioSysfs.getBufferLength());
+        return value ? std::optional<size_t>(static_cast<size_t>(*value)) : std::nullopt;
+    }
+
+    // Scans the buffer collects before poll() reports it readable, at most
+    // the length. Larger batches mean fewer wakeups and more latency; see
+    // StreamingSession::setPollTimeout(). Disables the buffer as well.
+    bool setBufferWatermark(size_t scans) {
+        disableBuffer();
+        return _backend->writeAttributeValue(_iioSysfs.getBufferWatermark(), static_cast<long long>(scans));
+    }
+
+    std::optional<size_t> getBufferWatermark() {
+        auto value = _backend->readAttributeValue(_iioSysfs.getBufferWatermark());
+        return value ? std::optional<size_t>(static_cast<size_t>(*value)) : std::nullopt;
+    }
+
     void setRegister(const std::string &reg, int value) {
         setAttribute(reg, std::to_string(value));
     }
@@ -129,7 +145,12 @@ public:
         return true;
     }
 
-    std::optional<std::vector<uint8_t>> readBuffer(size_t size = BUFFER_SIZE) {
+    // size 0 reads one record of the layout captured by enableBuffer().
+    std::optional<std::vector<uint8_t>> readBuffer(size_t size = 0) {
+        if (size == 0) {
+            size = _scanLayout && _scanLayout->recordSize() ?
+                _scanLayout->recordSize() : BUFFER_SIZE;
+        }
         std::ifstream adc_data_file(_iioSysfs.getBufferInterface(), std::ios::binary);
         if (!adc_data_file) {
             return std::nullopt;
@@ -141,53 +162,186 @@ public:
         return data;
     }
 
-    std::optional<ssize_t> writeRegister(ADS114S0XBRegister reg, const std::string &value) {
-        if (!_dev)
-            return std::nullopt;
+    // Preferred over triggerConversion()/readBuffer() in sampling loops:
+    // the session keeps both descriptors open for the whole acquisition.
+    StreamingSession createStreamingSession() const {
+        StreamingSession session(_iioSysfs);
+        session.setMetrics(_metrics.get());
+        return session;
+    }
+
+    // Awaitable reads and register access on reactor's thread, see
+    // AsyncSession. Attached to getMetrics().
+    std::unique_ptr<AsyncSession> createAsyncSession(Reactor &reactor) {
+        auto session = std::make_unique<AsyncSession>(reactor, *_backend, _iioSysfs);
+        session->setMetrics(_metrics.get());
+        return session;
+    }
 
-        auto ret = 
-            iio_device_attr_write(
-                _dev, 
-                registerMap.at(reg).c_str(),
-                value.c_str()) >= 0;
+    // Kernel-batched alternative to StreamingSession, see IioBufferAcquisition.
+    // Not attached to getMetrics(), call setMetrics() on it if wanted.
+    IioBufferAcquisition createIioBufferAcquisition(size_t samplesPerRefill, bool cyclic = false) const {
+        return IioBufferAcquisition(_backend->getIioDevice(), samplesPerRefill, cyclic);
+    }
+
+    // Started source over the channels enabled with setChannel(), from
+    // whichever backend this device uses. It enables the buffer itself, so
+    // do not call enableBuffer() first. nullptr on failure, see
+    // getLastErrno().
+    std::unique_ptr<SampleSource> createSampleSource(size_t samplesPerRead) {
+        auto source = _backend->createSampleSource(_channels, samplesPerRead);
+        if (source) {
+            source->setMetrics(_metrics.get());
+        }
+        return source;
+    }
 
-        if ( errno < 0) {
+    // Decoder for the layout captured by the last enableBuffer().
+    std::optional<ScanDecoder> createScanDecoder() const {
+        if (!_scanLayout) {
             return std::nullopt;
         }
+        return ScanDecoder(*_scanLayout);
+    }
 
-        return ret;
+    // False on failure, see getLastErrno().
+    bool writeRegister(ADS114S0XBRegister reg, const std::string &value) {
+        return _backend->writeAttribute(std::string(describe(reg).name), value);
     }
 
     std::optional<std::string> readRegister(ADS114S0XBRegister reg) {
-        if (!_dev)
+        return _backend->readAttribute(std::string(describe(reg).name));
+    }
+
+    // Numeric register access, no string building on either side.
+    std::optional<uint8_t> readRegisterValue(ADS114S0XBRegister reg) {
+        auto value = _backend->readAttributeValue(std::string(describe(reg).name));
+        if (!value) {
+            return std::nullopt;
+        }
+        return static_cast<uint8_t>(*value);
+    }
+
+    bool writeRegisterValue(ADS114S0XBRegister reg, uint8_t value) {
+        return _backend->writeAttributeValue(std::string(describe(reg).name), value);
+    }
+
+    // Writes a register composed at compile time, see RegisterValue.
+    template <ADS114S0XBRegister Reg>
+    bool write(RegisterValue<Reg> value) {
+        return writeRegisterValue(Reg, value.value);
+    }
+
+    // Read-modify-write of a single field, e.g. set(Pga::Gain::x16).
+    template <typename Field>
+    bool set(Field value) {
+        constexpr auto reg = FieldOf<Field>::reg;
+        auto current = readRegisterValue(reg);
+        if (!current) {
+            return false;
+        }
+        auto updated = static_cast<uint8_t>(
+            (*current & ~FieldOf<Field>::mask) | FieldOf<Field>::encode(value));
+        return updated == *current || writeRegisterValue(reg, updated);
+    }
+
+    template <typename Field>
+    std::optional<Field> get() {
+        auto current = readRegisterValue(FieldOf<Field>::reg);
+        if (!current) {
+            return std::nullopt;
+        }
+        return FieldOf<Field>::decode(*current);
+    }
+
+    // Burst access to consecutive registers through the driver's binary
+    // "registers" file: one SPI transfer for the whole block instead of
+    // one per register. first is the register address (0x00-0x11).
+    std::optional<size_t> readRegisterBlock(uint8_t first, std::span<uint8_t> values) {
+        return _backend->readRegisterBlock(first, values);
+    }
+
+    std::optional<size_t> writeRegisterBlock(uint8_t first, std::span<const uint8_t> values) {
+        return _backend->writeRegisterBlock(first, values);
+    }
+
+    // Runs command through the driver's "calibrate" attribute on the input
+    // INPMUX selects, at the current PGA and DATARATE. Blocks for CAL_SAMP
+    // conversions; the chip leaves the result in OFCAL or FSCAL. Fails with
+    // EBUSY while the buffer is enabled. See CalibrationCache.
+    bool calibrate(CalibrationCommand command) {
+        static constexpr const char *NAMES[] = {"SYOCAL", "SYGCAL", "SFOCAL"};
+        return _backend->writeAttribute(CALIBRATE, NAMES[static_cast<size_t>(command)]);
+    }
+
+    // Entries of the driver's per-channel calibration table, loaded by
+    // buffered scans when they switch channel; taken into account at the
+    // next buffer enable. See AdcBackend::writeCalibrationTable().
+    std::optional<size_t> writeCalibrationTable(int firstChannel, std::span<const uint8_t> entries) {
+        return _backend->writeCalibrationTable(firstChannel, entries);
+    }
+
+    // Transfer function for the current PGA/REF/OFCAL/FSCAL contents, read
+    // with a single burst over PGA (0x03) .. FSCAL1 (0x0f). See
+    // ConversionParams::fromRegisters() for externalVref and
+    // softwareCalibration.
+    std::optional<ConversionParams> readConversionParams(
+            double externalVref = ConversionParams::INTERNAL_VREF, bool softwareCalibration = false) {
+        constexpr auto first = describe(ADS114S0XBRegister::PGA).address;
+        std::array<uint8_t, describe(ADS114S0XBRegister::FSCAL1).address - first + 1> regs;
+        auto ret = readRegisterBlock(first, regs);
+        if (!ret || *ret != regs.size()) {
             return std::nullopt;
-        char buf[128];
-        auto ret =
-            iio_device_attr_read(
-                _dev, registerMap.at(reg).c_str(),
-                buf,
-                sizeof buf);
-        if ( ret < 0) {
+        }
+        auto at = [&](ADS114S0XBRegister reg) {
+            return regs[describe(reg).address - first];
+        };
+        return ConversionParams::fromRegisters(
+            {at(ADS114S0XBRegister::PGA)},
+            {at(ADS114S0XBRegister::REF)},
+            static_cast<int16_t>(at(ADS114S0XBRegister::OFCAL1) << 8 | at(ADS114S0XBRegister::OFCAL0)),
+            static_cast<uint16_t>(at(ADS114S0XBRegister::FSCAL1) << 8 | at(ADS114S0XBRegister::FSCAL0)),
+            externalVref, softwareCalibration);
+    }
+
+    // Channels enabled with setChannel() and the whole register map in one
+    // burst, for the header and CONFIG chunks of a capture file.
+    std::optional<CaptureConfig> readCaptureConfig() {
+        std::array<uint8_t, CAPTURE_REGISTERS> regs;
+        auto ret = readRegisterBlock(0, regs);
+        if (!ret || *ret != regs.size()) {
             return std::nullopt;
         }
-        return std::string(buf);
+        return CaptureConfig::make(_channels, regs);
     }
 
     int getLastErrno() const {
-        return _last_errno;
+        return _backend->getLastErrno();
+    }
+
+    AdcBackend &getBackend() {
+        return *_backend;
+    }
+
+    // Hot-path counters and latencies of the sessions and sources created
+    // by this device; pass it to AcquisitionEngine::setMetrics() as well
+    // for overruns and queue residency.
+    Metrics &getMetrics() const {
+        return *_metrics;
     }
 
 private:
-    struct iio_context *_ctx = nullptr;
-    struct iio_device *_dev = nullptr;
-    struct iio_device *_trigger = nullptr;
     static const size_t BUFFER_SIZE{2};
-    int _last_errno = 0;
+    static constexpr const char *CALIBRATE = "calibrate";
     std::string _lastFunctionError;
     IIOSysfsFilesUtil _iioSysfs;
+    std::unique_ptr<AdcBackend> _backend;
+    std::optional<ScanLayout> _scanLayout;
+    std::vector<int> _channels;
+    std::unique_ptr<Metrics> _metrics = std::make_unique<Metrics>();
 
     void setAttribute(const std::string &attr, const std::string &value) {
-        if (iio_device_attr_write(_dev, attr.c_str(), value.c_str()) < 0) {
+        if (!_backend->writeAttribute(attr, value)) {
             throw std::runtime_error("Failed to write attribute: " + attr);
         }
     }
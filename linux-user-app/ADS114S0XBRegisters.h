@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace adcs
+{
+enum class ADS114S0XBRegister {
+    DATARATE,
+    FSCAL0,
+    FSCAL1,
+    GPIOCON,
+    GPIODAT,
+    ID,
+    IDACMAG,
+    IDACMUX,
+    INPMUX,
+    OFCAL0,
+    OFCAL1,
+    PGA,
+    REF,
+    STATUS,
+    SYS,
+    VBIAS,
+    SENSOR_MOCK_MODE,
+    COUNT, //Sentinel Value
+};
+
+// Everything the control path needs to know about a register, resolved at
+// compile time. name is the driver's sysfs attribute.
+struct RegisterDescriptor {
+    ADS114S0XBRegister id;
+    uint8_t address;
+    std::string_view name;
+    uint8_t resetValue;
+    bool isVolatile; // as in the driver's regmap: never served from its cache
+};
+
+// Indexed by ADS114S0XBRegister, see the static_assert below.
+inline constexpr std::array<RegisterDescriptor, static_cast<size_t>(ADS114S0XBRegister::COUNT)>
+REGISTER_DESCRIPTORS = {{
+    {ADS114S0XBRegister::DATARATE, 0x04, "DATARATE", 0x14, false},
+    {ADS114S0XBRegister::FSCAL0, 0x0e, "FSCAL0", 0x00, false},
+    {ADS114S0XBRegister::FSCAL1, 0x0f, "FSCAL1", 0x40, false},
+    {ADS114S0XBRegister::GPIOCON, 0x11, "GPIOCON", 0x00, false},
+    {ADS114S0XBRegister::GPIODAT, 0x10, "GPIODAT", 0x00, true},
+    {ADS114S0XBRegister::ID, 0x00, "ID", 0x00, true},
+    {ADS114S0XBRegister::IDACMAG, 0x06, "IDACMAG", 0x00, false},
+    {ADS114S0XBRegister::IDACMUX, 0x07, "IDACMUX", 0xff, false},
+    {ADS114S0XBRegister::INPMUX, 0x02, "INPMUX", 0x01, false},
+    {ADS114S0XBRegister::OFCAL0, 0x0b, "OFCAL0", 0x00, false},
+    {ADS114S0XBRegister::OFCAL1, 0x0c, "OFCAL1", 0x00, false},
+    {ADS114S0XBRegister::PGA, 0x03, "PGA", 0x00, false},
+    {ADS114S0XBRegister::REF, 0x05, "REF", 0x10, false},
+    {ADS114S0XBRegister::STATUS, 0x01, "STATUS", 0x80, true},
+    {ADS114S0XBRegister::SYS, 0x09, "SYS", 0x10, false},
+    {ADS114S0XBRegister::VBIAS, 0x08, "VBIAS", 0x00, false},
+    {ADS114S0XBRegister::SENSOR_MOCK_MODE, 0xff, "SENSOR_MOCK_MODE", 0x00, false},
+}};
+
+constexpr bool descriptorsIndexedById() {
+    for (size_t i = 0; i < REGISTER_DESCRIPTORS.size(); i++) {
+        if (static_cast<size_t>(REGISTER_DESCRIPTORS[i].id) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(descriptorsIndexedById(), "REGISTER_DESCRIPTORS out of enum order");
+
+constexpr const RegisterDescriptor &describe(ADS114S0XBRegister reg) {
+    return REGISTER_DESCRIPTORS[static_cast<size_t>(reg)];
+}
+
+// A bit-field of one register, holding values of the enum ValueT.
+template <ADS114S0XBRegister Reg, unsigned Shift, unsigned Width, typename ValueT>
+struct BitField {
+    static_assert(Shift + Width <= 8, "field outside an 8-bit register");
+    using value_type = ValueT;
+    static constexpr ADS114S0XBRegister reg = Reg;
+    static constexpr uint8_t mask = static_cast<uint8_t>(((1u << Width) - 1) << Shift);
+
+    static constexpr uint8_t encode(ValueT value) {
+        return static_cast<uint8_t>(static_cast<unsigned>(value) << Shift) & mask;
+    }
+
+    static constexpr ValueT decode(uint8_t raw) {
+        return static_cast<ValueT>((raw & mask) >> Shift);
+    }
+};
+
+// Maps a field's value type to its BitField; specialised per field below.
+template <typename ValueT>
+struct FieldOf;
+
+#define ADS114S0XB_FIELD(type, reg, shift, width)                              \
+    template <>                                                                \
+    struct FieldOf<type> : BitField<ADS114S0XBRegister::reg, shift, width, type> {}
+
+namespace Inpmux {
+// Same codes for both mux sides; AIN6..AIN11 exist on the ADS114S08B only.
+enum class Positive : uint8_t {
+    AIN0, AIN1, AIN2, AIN3, AIN4, AIN5, AIN6, AIN7, AIN8, AIN9, AIN10, AIN11, AINCOM,
+};
+enum class Negative : uint8_t {
+    AIN0, AIN1, AIN2, AIN3, AIN4, AIN5, AIN6, AIN7, AIN8, AIN9, AIN10, AIN11, AINCOM,
+};
+} // namespace Inpmux
+ADS114S0XB_FIELD(Inpmux::Positive, INPMUX, 4, 4);
+ADS114S0XB_FIELD(Inpmux::Negative, INPMUX, 0, 4);
+
+namespace Pga {
+enum class Delay : uint8_t {
+    tMod14, tMod25, tMod64, tMod256, tMod1024, tMod2048, tMod4096, tMod1,
+};
+enum class Mode : uint8_t { Bypassed, Enabled };
+enum class Gain : uint8_t { x1, x2, x4, x8, x16, x32, x64, x128 };
+} // namespace Pga
+ADS114S0XB_FIELD(Pga::Delay, PGA, 5, 3);
+ADS114S0XB_FIELD(Pga::Mode, PGA, 3, 2);
+ADS114S0XB_FIELD(Pga::Gain, PGA, 0, 3);
+
+namespace Datarate {
+enum class GlobalChop : uint8_t { Disabled, Enabled };
+enum class Clock : uint8_t { Internal, External };
+enum class Mode : uint8_t { Continuous, SingleShot };
+enum class Filter : uint8_t { Sinc3, LowLatency };
+enum class Rate : uint8_t {
+    sps2_5, sps5, sps10, sps16_6, sps20, sps50, sps60, sps100,
+    sps200, sps400, sps800, sps1000, sps2000, sps4000,
+};
+} // namespace Datarate
+ADS114S0XB_FIELD(Datarate::GlobalChop, DATARATE, 7, 1);
+ADS114S0XB_FIELD(Datarate::Clock, DATARATE, 6, 1);
+ADS114S0XB_FIELD(Datarate::Mode, DATARATE, 5, 1);
+ADS114S0XB_FIELD(Datarate::Filter, DATARATE, 4, 1);
+ADS114S0XB_FIELD(Datarate::Rate, DATARATE, 0, 4);
+
+namespace Ref {
+enum class Monitor : uint8_t { Disabled, L0, L0L1, L0Sense };
+// Buffer bits are active low in the chip: Enabled encodes as 0.
+enum class PositiveBuffer : uint8_t { Enabled, Disabled };
+enum class NegativeBuffer : uint8_t { Enabled, Disabled };
+enum class Select : uint8_t { Refp0Refn0, Refp1Refn1, Internal };
+enum class Internal : uint8_t { Off, OnWhenConverting, AlwaysOn };
+} // namespace Ref
+ADS114S0XB_FIELD(Ref::Monitor, REF, 6, 2);
+ADS114S0XB_FIELD(Ref::PositiveBuffer, REF, 5, 1);
+ADS114S0XB_FIELD(Ref::NegativeBuffer, REF, 4, 1);
+ADS114S0XB_FIELD(Ref::Select, REF, 2, 2);
+ADS114S0XB_FIELD(Ref::Internal, REF, 0, 2);
+
+namespace Sys {
+enum class Monitor : uint8_t {
+    Disabled, PgaShort, Temperature, AvddAvss4, Dvdd4, Burnout0_2uA, Burnout1uA, Burnout10uA,
+};
+enum class CalibrationSamples : uint8_t { s1, s4, s8, s16 };
+} // namespace Sys
+ADS114S0XB_FIELD(Sys::Monitor, SYS, 5, 3);
+ADS114S0XB_FIELD(Sys::CalibrationSamples, SYS, 3, 2);
+
+#undef ADS114S0XB_FIELD
+
+// Value of one register composed from typed fields, starting from the reset
+// value. Everything is constexpr, so a full configuration folds to a byte:
+//   constexpr auto pga = RegisterValue<ADS114S0XBRegister::PGA>{}
+//       .with(Pga::Mode::Enabled).with(Pga::Gain::x16);
+template <ADS114S0XBRegister Reg>
+struct RegisterValue {
+    uint8_t value = describe(Reg).resetValue;
+
+    template <typename ValueT>
+    constexpr RegisterValue with(ValueT field) const {
+        static_assert(FieldOf<ValueT>::reg == Reg, "field belongs to another register");
+        return {static_cast<uint8_t>((value & ~FieldOf<ValueT>::mask) | FieldOf<ValueT>::encode(field))};
+    }
+
+    template <typename ValueT>
+    constexpr ValueT get() const {
+        static_assert(FieldOf<ValueT>::reg == Reg, "field belongs to another register");
+        return FieldOf<ValueT>::decode(value);
+    }
+};
+
+static_assert(RegisterValue<ADS114S0XBRegister::PGA>{}
+    .with(Pga::Mode::Enabled).with(Pga::Gain::x16).value == 0x0c);
+static_assert(RegisterValue<ADS114S0XBRegister::DATARATE>{}
+    .get<Datarate::Rate>() == Datarate::Rate::sps20);
+
+enum class ChipVariant { ADS114S06B, ADS114S08B };
+
+template <ChipVariant Chip>
+struct ChipTraits;
+
+template <>
+struct ChipTraits<ChipVariant::ADS114S06B> {
+    static constexpr std::string_view name{"ads114s06b"};
+    static constexpr unsigned numInputs = 6;
+};
+
+template <>
+struct ChipTraits<ChipVariant::ADS114S08B> {
+    static constexpr std::string_view name{"ads114s08b"};
+    static constexpr unsigned numInputs = 12;
+};
+
+// INPMUX for a differential pair, rejected at compile time when an input
+// does not exist on Chip (e.g. AIN8 on an ADS114S06B).
+template <ChipVariant Chip, Inpmux::Positive P, Inpmux::Negative N = Inpmux::Negative::AINCOM>
+constexpr RegisterValue<ADS114S0XBRegister::INPMUX> inputMux() {
+    static_assert(P == Inpmux::Positive::AINCOM ||
+        static_cast<unsigned>(P) < ChipTraits<Chip>::numInputs, "positive input not on this chip");
+    static_assert(N == Inpmux::Negative::AINCOM ||
+        static_cast<unsigned>(N) < ChipTraits<Chip>::numInputs, "negative input not on this chip");
+    return RegisterValue<ADS114S0XBRegister::INPMUX>{}.with(P).with(N);
+}
+
+} // namespace adcs
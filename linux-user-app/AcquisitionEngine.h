@@ -0,0 +1,261 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "Metrics.h"
+#include "SampleSource.h"
+#include "SpscRing.h"
+
+namespace adcs
+{
+// Largest scan of the family (ADS114S08B, 12 inputs).
+static constexpr size_t MAX_SCAN_CHANNELS = 12;
+
+// One decoded scan as it travels through the ring. values[] follows the
+// column order of the source's SampleBlock (see channelIds()).
+struct ScanRecord {
+    int64_t timestamp;
+    std::array<int16_t, MAX_SCAN_CHANNELS> values;
+};
+
+struct AcquisitionStats {
+    uint64_t scansRead = 0;
+    uint64_t reads = 0;
+    uint64_t readErrors = 0;
+    uint64_t overruns = 0; // scans dropped because the ring was full
+};
+
+// Drains a SampleSource on a dedicated (optionally pinned) reader thread
+// into a lock-free SPSC ring, so a slow consumer costs ring space instead
+// of missed conversions. Exactly one thread may call the pop functions.
+class AcquisitionEngine {
+public:
+    AcquisitionEngine(SampleSource &source, size_t ringCapacity, size_t readBatch = 256) :
+        _source(source),
+        _ring(ringCapacity),
+        _marks(ringCapacity / std::max<size_t>(readBatch, 1) + 2),
+        _readBatch(readBatch) {
+        _source.prepare(_block, _readBatch);
+        _staging.resize(_block.capacity());
+    }
+
+    AcquisitionEngine(const AcquisitionEngine &) = delete;
+    AcquisitionEngine &operator=(const AcquisitionEngine &) = delete;
+
+    ~AcquisitionEngine() {
+        stop();
+    }
+
+    // Starts the reader thread, pinned to cpu when cpu >= 0. Returns 0 or
+    // the pthread_setaffinity_np() error (the thread keeps running unpinned).
+    int start(int cpu = -1) {
+        if (_running.exchange(true)) {
+            return 0;
+        }
+        if (_thread.joinable()) {
+            _thread.join(); // reader that stopped on its own
+        }
+        _lastErrno = 0;
+        _thread = std::thread([this] { readerLoop(); });
+        if (cpu >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(cpu, &cpuset);
+            return pthread_setaffinity_np(_thread.native_handle(), sizeof cpuset, &cpuset);
+        }
+        return 0;
+    }
+
+    // Records overruns and queue residency into metrics, and hands it to
+    // the source for the read and decode stages. Call before start().
+    void setMetrics(Metrics *metrics) {
+        _metrics = metrics;
+        _source.setMetrics(metrics);
+    }
+
+    // Makes the reader wait for ring space instead of dropping scans, for
+    // sources that can be paused such as ReplaySource. Never for the live
+    // device: the kernel buffer would overflow instead. Call before start().
+    void setLossless(bool lossless) {
+        _lossless = lossless;
+    }
+
+    // Returns once the in-flight source read has completed.
+    void stop() {
+        _running = false;
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    bool isRunning() const {
+        return _running;
+    }
+
+    size_t popBatch(std::span<ScanRecord> out) {
+        auto count = _ring.tryPopBatch(out.data(), out.size());
+        retired(count);
+        return count;
+    }
+
+    // Pops up to block.capacity() scans and transposes them into columns.
+    // block must have been prepared with channelIds().
+    size_t popBatch(SampleBlock &block) {
+        ScanRecord scans[64];
+        size_t total = 0;
+        while (total < block.capacity()) {
+            auto want = std::min(std::size(scans), block.capacity() - total);
+            auto count = _ring.tryPopBatch(scans, want);
+            for (size_t c = 0; c < block.channelCount(); c++) {
+                auto column = block.channels[c].data() + total;
+                for (size_t i = 0; i < count; i++) {
+                    column[i] = scans[i].values[c];
+                }
+            }
+            for (size_t i = 0; i < count; i++) {
+                block.timestamps[total + i] = scans[i].timestamp;
+            }
+            total += count;
+            retired(count);
+            if (count < want) {
+                break;
+            }
+        }
+        block.size = total;
+        return total;
+    }
+
+    const std::vector<int> &channelIds() const {
+        return _block.channelIds;
+    }
+
+    size_t queued() const {
+        return _ring.size();
+    }
+
+    AcquisitionStats getStats() const {
+        AcquisitionStats stats;
+        stats.scansRead = _scansRead.load(std::memory_order_relaxed);
+        stats.reads = _reads.load(std::memory_order_relaxed);
+        stats.readErrors = _readErrors.load(std::memory_order_relaxed);
+        stats.overruns = _overruns.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // errno of the read that stopped the reader thread, 0 otherwise.
+    int getLastErrno() const {
+        return _lastErrno;
+    }
+
+private:
+    // Push time of each batch, so residency costs one mark per read rather
+    // than a timestamp in every ScanRecord. end is the running scan count
+    // after the batch.
+    struct BatchMark {
+        uint64_t end;
+        int64_t pushedAt;
+    };
+
+    SampleSource &_source;
+    SpscRing<ScanRecord> _ring;
+    SpscRing<BatchMark> _marks;
+    size_t _readBatch;
+    SampleBlock _block;
+    std::vector<ScanRecord> _staging;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<int> _lastErrno{0};
+    Metrics *_metrics = nullptr;
+    bool _lossless = false;
+    uint64_t _pushed = 0;              // reader thread
+    uint64_t _popped = 0;              // consumer thread
+    std::optional<BatchMark> _pendingMark;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> _scansRead{0};
+    std::atomic<uint64_t> _reads{0};
+    std::atomic<uint64_t> _readErrors{0};
+    std::atomic<uint64_t> _overruns{0};
+
+    void readerLoop() {
+        auto columns = std::min(_block.channelCount(), MAX_SCAN_CHANNELS);
+        while (_running.load(std::memory_order_relaxed)) {
+            auto ret = _source.read(_block);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                _readErrors.fetch_add(1, std::memory_order_relaxed);
+                _lastErrno = errno;
+                break;
+            }
+            if (ret == 0) {
+                break; // end of stream
+            }
+            _reads.fetch_add(1, std::memory_order_relaxed);
+
+            size_t scans = static_cast<size_t>(ret);
+            for (size_t i = 0; i < scans; i++) {
+                auto &record = _staging[i];
+                record.timestamp = _block.timestamps[i];
+                for (size_t c = 0; c < columns; c++) {
+                    record.values[c] = _block.channels[c][i];
+                }
+            }
+            auto pushed = _ring.tryPushBatch(_staging.data(), scans);
+            while (_lossless && pushed < scans && _running.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+                pushed += _ring.tryPushBatch(_staging.data() + pushed, scans - pushed);
+            }
+            _scansRead.fetch_add(scans, std::memory_order_relaxed);
+            if (pushed < scans) {
+                _overruns.fetch_add(scans - pushed, std::memory_order_relaxed);
+            }
+            if (METRICS_ENABLED && _metrics) {
+                _metrics->overruns.add(scans - pushed);
+                _pushed += pushed;
+                // A full mark ring only loses samples of the residency
+                if (pushed > 0) {
+                    _marks.tryPush({_pushed, metricsNow()});
+                }
+            }
+        }
+        _running = false;
+    }
+
+    // Consumer side: records the residency of every batch whose last scan
+    // has now been popped.
+    void retired(size_t count) {
+        if (!METRICS_ENABLED || !_metrics || count == 0) {
+            return;
+        }
+        _popped += count;
+        int64_t now = 0;
+        for (;;) {
+            if (!_pendingMark) {
+                BatchMark mark;
+                if (!_marks.tryPop(mark)) {
+                    return;
+                }
+                _pendingMark = mark;
+            }
+            if (_pendingMark->end > _popped) {
+                return;
+            }
+            now = now ? now : metricsNow();
+            _metrics->queueResidency.record(static_cast<uint64_t>(now - _pendingMark->pushedAt));
+            _pendingMark.reset();
+        }
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <iio.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SampleSource.h"
+#include "ScanDecoder.h"
+
+namespace adcs
+{
+// Bytes per channel in AdcBackend::writeCalibrationTable().
+inline constexpr size_t CALIBRATION_ENTRY_SIZE = 5;
+
+// Everything ADS114S0XB needs from the device, so the same control and
+// data path runs against the kernel driver (LibiioBackend) or an
+// in-process stand-in (SimulatedBackend).
+//
+// Attributes use the driver's sysfs names relative to the device
+// directory: register names such as "PGA", "SENSOR_MOCK_MODE",
+// "scan_elements/in_voltageN_en" and "buffer/enable".
+class AdcBackend {
+public:
+    virtual ~AdcBackend() = default;
+
+    // Same convention as ADS114S0XB::initialize(): {errno, failing call}.
+    // uri is a libiio context URI; empty selects the default context.
+    virtual std::pair<int, std::string> open(const std::string &uri = "") = 0;
+
+    virtual std::optional<std::string> readAttribute(const std::string &name) = 0;
+    virtual bool writeAttribute(const std::string &name, const std::string &value) = 0;
+
+    virtual std::optional<long long> readAttributeValue(const std::string &name) {
+        auto value = readAttribute(name);
+        if (!value) {
+            return std::nullopt;
+        }
+        return std::strtoll(value->c_str(), nullptr, 0);
+    }
+
+    virtual bool writeAttributeValue(const std::string &name, long long value) {
+        return writeAttribute(name, std::to_string(value));
+    }
+
+    // Burst access to consecutive registers starting at address first.
+    virtual std::optional<size_t> readRegisterBlock(uint8_t first, std::span<uint8_t> values) = 0;
+    virtual std::optional<size_t> writeRegisterBlock(uint8_t first, std::span<const uint8_t> values) = 0;
+
+    // The driver's per-channel calibration table: OFCAL0..FSCAL1 (5 bytes,
+    // see CALIBRATION_ENTRY_SIZE) of each channel, which buffered scans load
+    // whenever they switch to that channel. entries covers whole entries of
+    // consecutive channels starting at firstChannel (EINVAL otherwise);
+    // writing the reset words (offset 0, FSCAL 0x4000) removes an entry.
+    virtual std::optional<size_t> writeCalibrationTable(int firstChannel, std::span<const uint8_t> entries) = 0;
+
+    // Record layout of the enabled scan elements; empty when unknown.
+    virtual std::optional<ScanLayout> scanLayout() = 0;
+
+    // Buffered source over channels, enabling the device buffer for as
+    // long as the source lives. nullptr on failure, see getLastErrno().
+    virtual std::unique_ptr<SampleSource> createSampleSource(const std::vector<int> &channels,
+        size_t samplesPerRead) = 0;
+
+    // libiio handle for the callers that need one, nullptr if there is none.
+    virtual struct iio_device *getIioDevice() const {
+        return nullptr;
+    }
+
+    virtual int getLastErrno() const = 0;
+};
+
+} // namespace adcs
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ADS114S0XBRegisters.h"
+#include "AdcBackend.h"
+#include "IIOSysfsFilesUtil.h"
+#include "Metrics.h"
+#include "Reactor.h"
+#include "ScanDecoder.h"
+
+namespace adcs
+{
+// Awaitable counterpart of StreamingSession for event-driven programs:
+// the buffer character device is opened non-blocking and watched by a
+// Reactor, so one thread can serve many ADCs. Register access goes to the
+// reactor's worker thread, as sysfs attributes cannot be polled. Not
+// movable, the reactor holds on to it between open() and close().
+class AsyncSession {
+public:
+    AsyncSession(Reactor &reactor, AdcBackend &backend, const IIOSysfsFilesUtil &iioSysfs = IIOSysfsFilesUtil()) :
+        AsyncSession(reactor, backend, iioSysfs.getBufferInterface()) {
+    }
+
+    AsyncSession(Reactor &reactor, AdcBackend &backend, const std::string &bufferPath) :
+        _reactor(reactor),
+        _backend(backend),
+        _bufferPath(bufferPath) {
+    }
+
+    AsyncSession(const AsyncSession &) = delete;
+    AsyncSession &operator=(const AsyncSession &) = delete;
+
+    ~AsyncSession() {
+        close();
+    }
+
+    // Same convention as ADS114S0XB::initialize(): {errno, failing call}.
+    // The buffer has to be enabled already, see ADS114S0XB::enableBuffer().
+    std::pair<int, std::string> open() {
+        if (isOpen()) {
+            return {0, "already open"};
+        }
+        _watch.fd = ::open(_bufferPath.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (_watch.fd < 0) {
+            _last_errno = errno;
+            return {_last_errno, "open " + _bufferPath};
+        }
+        if (auto status = _reactor.add(_watch); status.first != 0) {
+            _last_errno = status.first;
+            ::close(_watch.fd);
+            _watch.fd = -1;
+            return status;
+        }
+        return {0, ""};
+    }
+
+    void close() {
+        if (_watch.fd >= 0) {
+            _reactor.remove(_watch);
+            ::close(_watch.fd);
+            _watch.fd = -1;
+        }
+    }
+
+    bool isOpen() const {
+        return _watch.fd >= 0;
+    }
+
+    // Records reads, bytes, errors and decoding into metrics, nullptr to stop.
+    void setMetrics(Metrics *metrics) {
+        _metrics = metrics;
+    }
+
+    // Whatever the buffer holds, up to data.size() bytes, suspending while
+    // it is empty. Returns the number of bytes, or -1 with getLastErrno()
+    // set. At most one read may be pending per session.
+    Task<ssize_t> readBlock(std::span<uint8_t> data) {
+        for (;;) {
+            auto ret = ::read(_watch.fd, data.data(), data.size());
+            if (ret >= 0) {
+                if (METRICS_ENABLED && _metrics) {
+                    _metrics->reads.add();
+                    _metrics->bytesRead.add(static_cast<uint64_t>(ret));
+                    if (static_cast<size_t>(ret) < data.size()) {
+                        _metrics->shortReads.add();
+                    }
+                }
+                co_return ret;
+            }
+            if (errno == EAGAIN) {
+                co_await _reactor.readable(_watch);
+            }
+            else if (errno != EINTR) {
+                _last_errno = errno;
+                if (METRICS_ENABLED && _metrics) {
+                    _metrics->readErrors.add();
+                }
+                co_return -1;
+            }
+        }
+    }
+
+    // Up to block.capacity() records, decoded in place, as
+    // StreamingSession::readRecords(). Returns the number of records, or -1.
+    Task<ssize_t> readRecords(const ScanDecoder &decoder, SampleBlock &block) {
+        size_t bytes = block.capacity() * decoder.recordSize();
+        if (_raw.size() < bytes) {
+            _raw.resize(bytes);
+        }
+        auto ret = co_await readBlock({_raw.data(), bytes});
+        if (ret < 0) {
+            block.size = 0;
+            co_return ret;
+        }
+        if (METRICS_ENABLED && _metrics) {
+            auto start = metricsNow();
+            auto scans = decoder.decode({_raw.data(), static_cast<size_t>(ret)}, block);
+            _metrics->decode.recordSince(start);
+            _metrics->scansDecoded.add(scans);
+            co_return static_cast<ssize_t>(scans);
+        }
+        co_return static_cast<ssize_t>(decoder.decode({_raw.data(), static_cast<size_t>(ret)}, block));
+    }
+
+    Task<std::optional<uint8_t>> readRegisterAsync(ADS114S0XBRegister reg) {
+        auto value = co_await _reactor.offload([this, reg] {
+            return _backend.readAttributeValue(std::string(describe(reg).name));
+        });
+        co_return value ? std::optional<uint8_t>(static_cast<uint8_t>(*value)) : std::nullopt;
+    }
+
+    Task<bool> writeRegisterAsync(ADS114S0XBRegister reg, uint8_t value) {
+        co_return co_await _reactor.offload([this, reg, value] {
+            return _backend.writeAttributeValue(std::string(describe(reg).name), value);
+        });
+    }
+
+    // Burst read over the "registers" file, see ADS114S0XB::readRegisterBlock().
+    Task<std::optional<size_t>> readRegisterBlockAsync(uint8_t first, std::span<uint8_t> values) {
+        co_return co_await _reactor.offload([this, first, values] {
+            return _backend.readRegisterBlock(first, values);
+        });
+    }
+
+    int getLastErrno() const {
+        return _last_errno;
+    }
+
+private:
+    Reactor &_reactor;
+    AdcBackend &_backend;
+    std::string _bufferPath;
+    FdWatch _watch;
+    int _last_errno = 0;
+    std::vector<uint8_t> _raw;
+    Metrics *_metrics = nullptr;
+};
+
+} // namespace adcs
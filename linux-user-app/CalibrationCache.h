@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ADS114S0XB.h"
+
+namespace adcs
+{
+// What a set of calibration words is valid for: the chip calibrates the
+// signal path of one input at one PGA gain and data rate.
+struct CalibrationKey {
+    int channel = 0;
+    Pga::Gain gain = Pga::Gain::x1;
+    Datarate::Rate rate = Datarate::Rate::sps20;
+
+    auto operator<=>(const CalibrationKey &) const = default;
+};
+
+// OFCAL1:OFCAL0 and FSCAL1:FSCAL0, reset values by default.
+struct CalibrationWords {
+    int16_t offset = 0;
+    uint16_t fullScale = 0x4000;
+
+    // OFCAL0..FSCAL1 as one burst writes them; 0x0d is reserved and stays 0.
+    std::array<uint8_t, CALIBRATION_ENTRY_SIZE> registers() const {
+        auto o = static_cast<uint16_t>(offset);
+        return {static_cast<uint8_t>(o), static_cast<uint8_t>(o >> 8), 0,
+            static_cast<uint8_t>(fullScale), static_cast<uint8_t>(fullScale >> 8)};
+    }
+
+    static CalibrationWords fromRegisters(std::span<const uint8_t, CALIBRATION_ENTRY_SIZE> regs) {
+        return {static_cast<int16_t>(regs[1] << 8 | regs[0]), static_cast<uint16_t>(regs[4] << 8 | regs[3])};
+    }
+
+    bool operator==(const CalibrationWords &) const = default;
+};
+
+// SFOCAL is the only command that needs nothing applied to the inputs.
+inline constexpr CalibrationCommand DEFAULT_CALIBRATION[] = {CalibrationCommand::SelfOffset};
+
+// Calibration results per (channel, PGA gain, data rate), kept in a file
+// so that a restart or a reconfiguration reloads them instead of running
+// the calibration commands again. A command averages CAL_SAMP conversions,
+// which at the low data rates is seconds per channel and gain; reloading
+// is one burst write of OFCAL0..FSCAL1.
+//
+// The file is text, one entry per line, "channel gain rate offset
+// fullscale", with gain and rate as their register codes and the words in
+// decimal. Lines starting with '#' are comments.
+class CalibrationCache {
+public:
+    // Merges the entries of path into the cache, replacing those with the
+    // same key. A missing file is an empty cache. Same convention as
+    // ADS114S0XB::initialize(): {errno, failing call}.
+    std::pair<int, std::string> load(const std::string &path) {
+        FILE *in = fopen(path.c_str(), "r");
+        if (!in) {
+            if (errno == ENOENT) {
+                return {0, ""};
+            }
+            return {errno, "fopen " + path};
+        }
+        char line[128];
+        bool parsed = true;
+        while (parsed && fgets(line, sizeof line, in)) {
+            if (line[0] == '#' || line[0] == '\n') {
+                continue;
+            }
+            int channel, offset;
+            unsigned gain, rate, fullScale;
+            parsed = sscanf(line, "%d %u %u %d %u", &channel, &gain, &rate, &offset, &fullScale) == 5 &&
+                channel >= 0 && static_cast<size_t>(channel) < MAX_SCAN_CHANNELS &&
+                gain <= FieldOf<Pga::Gain>::mask && rate <= FieldOf<Datarate::Rate>::mask &&
+                offset >= INT16_MIN && offset <= INT16_MAX && fullScale <= UINT16_MAX;
+            if (parsed) {
+                _entries[{channel, static_cast<Pga::Gain>(gain), static_cast<Datarate::Rate>(rate)}] =
+                    {static_cast<int16_t>(offset), static_cast<uint16_t>(fullScale)};
+            }
+        }
+        bool failed = ferror(in);
+        fclose(in);
+        if (!parsed) {
+            return {EINVAL, "parse " + path};
+        }
+        if (failed) {
+            return {EIO, "fgets " + path};
+        }
+        return {0, ""};
+    }
+
+    // Written to a temporary file and renamed, so a crash never leaves
+    // half a cache behind.
+    std::pair<int, std::string> save(const std::string &path) {
+        auto tmp = path + ".tmp";
+        FILE *out = fopen(tmp.c_str(), "w");
+        if (!out) {
+            return {errno, "fopen " + tmp};
+        }
+        fprintf(out, "# ads114s0xb calibration: channel gain rate offset fullscale\n");
+        for (const auto &[key, words] : _entries) {
+            fprintf(out, "%d %u %u %d %u\n", key.channel, static_cast<unsigned>(key.gain),
+                static_cast<unsigned>(key.rate), words.offset, words.fullScale);
+        }
+        bool ok = fflush(out) == 0;
+        ok = fclose(out) == 0 && ok;
+        if (!ok) {
+            auto err = errno;
+            remove(tmp.c_str());
+            return {err, "write " + tmp};
+        }
+        if (rename(tmp.c_str(), path.c_str()) < 0) {
+            return {errno, "rename " + tmp};
+        }
+        _dirty = false;
+        return {0, ""};
+    }
+
+    std::optional<CalibrationWords> find(const CalibrationKey &key) const {
+        auto it = _entries.find(key);
+        if (it == _entries.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void store(const CalibrationKey &key, const CalibrationWords &words) {
+        _entries[key] = words;
+        _dirty = true;
+    }
+
+    void clear() {
+        _dirty |= !_entries.empty();
+        _entries.clear();
+    }
+
+    size_t size() const {
+        return _entries.size();
+    }
+
+    // Changed since the last save().
+    bool isDirty() const {
+        return _dirty;
+    }
+
+    // Calibrations run by calibrate(), apply() and prepareScan().
+    uint64_t calibrationsRun() const {
+        return _calibrationsRun;
+    }
+
+    // Key of channel at the device's current PGA gain and data rate, read
+    // with one burst over PGA and DATARATE.
+    static std::optional<CalibrationKey> currentKey(ADS114S0XB &adc, int channel) {
+        constexpr auto pga = describe(ADS114S0XBRegister::PGA).address;
+        std::array<uint8_t, 2> regs; // PGA, DATARATE
+        auto ret = adc.readRegisterBlock(pga, regs);
+        if (!ret || *ret != regs.size()) {
+            return std::nullopt;
+        }
+        return CalibrationKey{channel, FieldOf<Pga::Gain>::decode(regs[0]), FieldOf<Datarate::Rate>::decode(regs[1])};
+    }
+
+    // Selects channel, runs commands in order at the current PGA gain and
+    // data rate and stores what the chip left in OFCAL/FSCAL. The words
+    // start from their reset values, so the result does not depend on the
+    // channel calibrated before; put offset commands before SYGCAL, which
+    // measures with the offset already corrected. Needs the buffer
+    // disabled.
+    std::optional<CalibrationWords> calibrate(ADS114S0XB &adc, int channel,
+            std::span<const CalibrationCommand> commands = DEFAULT_CALIBRATION) {
+        auto key = currentKey(adc, channel);
+        auto reset = CalibrationWords{}.registers();
+        if (!key || !adc.writeRegisterValue(ADS114S0XBRegister::INPMUX, static_cast<uint8_t>(channel)) ||
+                adc.writeRegisterBlock(OFCAL0, reset) != reset.size()) {
+            return std::nullopt;
+        }
+        _calibrationsRun++;
+        for (auto command : commands) {
+            if (!adc.calibrate(command)) {
+                return std::nullopt;
+            }
+        }
+        std::array<uint8_t, CALIBRATION_ENTRY_SIZE> regs;
+        if (adc.readRegisterBlock(OFCAL0, regs) != regs.size()) {
+            return std::nullopt;
+        }
+        auto words = CalibrationWords::fromRegisters(regs);
+        store(*key, words);
+        return words;
+    }
+
+    // Loads channel's calibration for the current PGA gain and data rate
+    // into OFCAL/FSCAL, with one burst write when it is cached and with
+    // calibrate() otherwise. For direct reads, after switching channel or
+    // gain; buffered scans use prepareScan().
+    std::optional<CalibrationWords> apply(ADS114S0XB &adc, int channel,
+            std::span<const CalibrationCommand> commands = DEFAULT_CALIBRATION) {
+        auto key = currentKey(adc, channel);
+        if (!key) {
+            return std::nullopt;
+        }
+        if (auto words = find(*key)) {
+            auto regs = words->registers();
+            if (adc.writeRegisterBlock(OFCAL0, regs) != regs.size()) {
+                return std::nullopt;
+            }
+            return words;
+        }
+        return calibrate(adc, channel, commands);
+    }
+
+    // A buffered scan switches channel within every scan, so the driver
+    // loads each channel's words itself from its calibration table. This
+    // fills the table for channels at the current PGA gain and data rate,
+    // calibrating the channels not cached yet, with one write per run of
+    // consecutive channels. Call with the buffer disabled, again after a
+    // gain or data rate change; the driver takes the table at the next
+    // buffer enable. The driver treats an entry of reset words as none and
+    // gives such channels OFCAL/FSCAL as they are at enable, so those are
+    // set to the reset words as well rather than left at the last
+    // calibration.
+    bool prepareScan(ADS114S0XB &adc, std::span<const int> channels,
+            std::span<const CalibrationCommand> commands = DEFAULT_CALIBRATION) {
+        std::vector<int> sorted(channels.begin(), channels.end());
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        std::vector<uint8_t> entries;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            auto key = currentKey(adc, sorted[i]);
+            if (!key) {
+                return false;
+            }
+            auto words = find(*key);
+            if (!words) {
+                words = calibrate(adc, sorted[i], commands);
+                if (!words) {
+                    return false;
+                }
+            }
+            auto regs = words->registers();
+            entries.insert(entries.end(), regs.begin(), regs.end());
+            // Flush at the end of a run of consecutive channels
+            if (i + 1 == sorted.size() || sorted[i + 1] != sorted[i] + 1) {
+                auto first = sorted[i] - static_cast<int>(entries.size() / CALIBRATION_ENTRY_SIZE) + 1;
+                if (adc.writeCalibrationTable(first, entries) != entries.size()) {
+                    return false;
+                }
+                entries.clear();
+            }
+        }
+        auto reset = CalibrationWords{}.registers();
+        return adc.writeRegisterBlock(OFCAL0, reset) == reset.size();
+    }
+
+private:
+    static constexpr uint8_t OFCAL0 = describe(ADS114S0XBRegister::OFCAL0).address;
+
+    std::map<CalibrationKey, CalibrationWords> _entries;
+    uint64_t _calibrationsRun = 0;
+    bool _dirty = false;
+};
+
+} // namespace adcs
@@ -0,0 +1,747 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ADS114S0XBRegisters.h"
+#include "AcquisitionEngine.h"
+#include "SampleBlock.h"
+#include "SpscRing.h"
+#include "VoltageConverter.h"
+
+namespace adcs
+{
+// Binary capture files. Little-endian, and every part starts on a
+// CAPTURE_ALIGNMENT boundary so the writer can use O_DIRECT:
+//
+//   CaptureFileHeader       first block
+//   chunks                  CaptureChunkHeader + payload, padded to whole blocks
+//   CaptureIndexEntry[n]    one per chunk, written by CaptureWriter::close()
+//   CaptureIndexTrailer     last 32 bytes
+//
+// A DATA chunk holds `scans` int64 timestamps followed by one int16 column
+// of `scans` codes per channel. A CONFIG chunk holds a CaptureConfig that
+// applies to the chunks after it, the header's to those before the first.
+// Files without the trailer (capture killed) stay readable: CaptureReader
+// then rebuilds the index from the chunk headers.
+static constexpr size_t CAPTURE_ALIGNMENT = 4096;
+static constexpr size_t CAPTURE_REGISTERS = 0x12; // ID..GPIOCON
+static constexpr uint32_t CAPTURE_VERSION = 1;
+static constexpr char CAPTURE_MAGIC[8] = {'A', 'D', 'S', 'C', 'A', 'P', 'T', '\0'};
+static constexpr char CAPTURE_INDEX_MAGIC[8] = {'A', 'D', 'S', 'I', 'N', 'D', 'X', '\0'};
+static constexpr uint32_t CAPTURE_CHUNK_MAGIC = 0x4b484341; // "ACHK"
+
+enum class CaptureChunkType : uint16_t { Data = 1, Config = 2 };
+
+// Scan layout and the full register map at the time it was recorded.
+struct CaptureConfig {
+    uint8_t channelCount = 0;
+    uint8_t channelIds[MAX_SCAN_CHANNELS] = {};
+    uint8_t registers[CAPTURE_REGISTERS] = {};
+    uint8_t reserved = 0;
+
+    // registers holds addresses 0x00..0x11, as read by readRegisterBlock(0, ...).
+    static CaptureConfig make(const std::vector<int> &channels, std::span<const uint8_t> registers) {
+        CaptureConfig config;
+        config.channelCount = static_cast<uint8_t>(std::min(channels.size(), MAX_SCAN_CHANNELS));
+        for (size_t i = 0; i < config.channelCount; i++) {
+            config.channelIds[i] = static_cast<uint8_t>(channels[i]);
+        }
+        std::copy_n(registers.begin(), std::min(registers.size(), CAPTURE_REGISTERS), config.registers);
+        return config;
+    }
+
+    std::vector<int> channels() const {
+        return {channelIds, channelIds + channelCount};
+    }
+
+    uint8_t reg(ADS114S0XBRegister reg) const {
+        auto address = describe(reg).address;
+        return address < CAPTURE_REGISTERS ? registers[address] : 0;
+    }
+
+    ConversionParams conversionParams(double externalVref = ConversionParams::INTERNAL_VREF,
+            bool softwareCalibration = false) const {
+        return ConversionParams::fromRegisters(
+            {reg(ADS114S0XBRegister::PGA)},
+            {reg(ADS114S0XBRegister::REF)},
+            static_cast<int16_t>(reg(ADS114S0XBRegister::OFCAL1) << 8 | reg(ADS114S0XBRegister::OFCAL0)),
+            static_cast<uint16_t>(reg(ADS114S0XBRegister::FSCAL1) << 8 | reg(ADS114S0XBRegister::FSCAL0)),
+            externalVref, softwareCalibration);
+    }
+};
+static_assert(sizeof(CaptureConfig) == 32);
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t alignment;
+    uint32_t chunkBytes;
+    uint32_t reserved;
+    int64_t createdNs; // CLOCK_REALTIME
+    CaptureConfig config;
+};
+static_assert(sizeof(CaptureFileHeader) == 64);
+
+struct CaptureChunkHeader {
+    uint32_t magic;
+    CaptureChunkType type;
+    uint16_t channels;
+    uint32_t scans;
+    uint32_t size; // whole chunk, header and padding included
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+};
+static_assert(sizeof(CaptureChunkHeader) == 32);
+
+struct CaptureIndexEntry {
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    uint64_t offset;
+    uint32_t scans;
+    CaptureChunkType type;
+    uint16_t config; // filled in by the reader
+};
+static_assert(sizeof(CaptureIndexEntry) == 32);
+
+struct CaptureIndexTrailer {
+    char magic[8];
+    uint64_t entries;
+    uint64_t indexOffset;
+    uint64_t reserved;
+};
+static_assert(sizeof(CaptureIndexTrailer) == 32);
+
+struct CaptureWriterOptions {
+    size_t chunkBytes = 256 * 1024; // rounded up to CAPTURE_ALIGNMENT
+    size_t buffers = 8;             // chunks in flight before append() drops
+    bool directIo = false;          // O_DIRECT; not every filesystem has it
+};
+
+// Append-only capture writer. append() only copies into the current chunk
+// buffer; full chunks go to a background thread that writes whatever has
+// piled up with a single pwritev(), so the acquisition side never waits on
+// the disk. When every buffer is in flight the scans are dropped and
+// counted instead. append() and writeConfig() belong to one thread.
+class CaptureWriter {
+public:
+    explicit CaptureWriter(const CaptureWriterOptions &options = CaptureWriterOptions()) :
+        _options(normalized(options)),
+        _free(_options.buffers),
+        _full(_options.buffers) {
+    }
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    ~CaptureWriter() {
+        close();
+    }
+
+    std::pair<int, std::string> open(const std::string &path, const CaptureConfig &config) {
+        if (_fd >= 0) {
+            return {0, "already open"};
+        }
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | (_options.directIo ? O_DIRECT : 0);
+        _fd = ::open(path.c_str(), flags, 0644);
+        if (_fd < 0) {
+            return {errno, "open " + path};
+        }
+        for (size_t i = 0; i < _options.buffers; i++) {
+            auto buffer = static_cast<uint8_t *>(std::aligned_alloc(CAPTURE_ALIGNMENT, _options.chunkBytes));
+            if (!buffer) {
+                release();
+                return {ENOMEM, "aligned_alloc"};
+            }
+            _buffers.push_back(buffer);
+            _free.tryPush(buffer);
+        }
+
+        auto header = reinterpret_cast<CaptureFileHeader *>(_buffers[0]);
+        memset(_buffers[0], 0, CAPTURE_ALIGNMENT);
+        memcpy(header->magic, CAPTURE_MAGIC, sizeof header->magic);
+        header->version = CAPTURE_VERSION;
+        header->alignment = CAPTURE_ALIGNMENT;
+        header->chunkBytes = static_cast<uint32_t>(_options.chunkBytes);
+        header->createdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header->config = config;
+        if (::pwrite(_fd, _buffers[0], CAPTURE_ALIGNMENT, 0) != static_cast<ssize_t>(CAPTURE_ALIGNMENT)) {
+            auto err = errno ? errno : EIO;
+            release();
+            return {err, "write " + path};
+        }
+
+        _fileOffset = CAPTURE_ALIGNMENT;
+        _index.clear();
+        _dropped = 0;
+        _bytesWritten = 0;
+        _lastErrno = 0;
+        _failed = false;
+        _stopping = false;
+        setLayout(config);
+        _current = nullptr;
+        _free.tryPop(_current);
+        _scans = 0;
+        _thread = std::thread([this] { writerLoop(); });
+        return {0, ""};
+    }
+
+    // Appends block, whose columns must follow the current config. Returns
+    // false if some or all of it was dropped.
+    bool append(const SampleBlock &block) {
+        if (_fd < 0 || block.channelCount() != _channels || _failed.load(std::memory_order_relaxed)) {
+            _dropped.fetch_add(block.size, std::memory_order_relaxed);
+            return false;
+        }
+        size_t done = 0;
+        while (done < block.size) {
+            if (!_current && !_free.tryPop(_current)) {
+                _dropped.fetch_add(block.size - done, std::memory_order_relaxed);
+                return false;
+            }
+            auto count = std::min(block.size - done, _capacity - _scans);
+            memcpy(timestamps(_current) + _scans, block.timestamps.data() + done, count * sizeof(int64_t));
+            for (size_t c = 0; c < _channels; c++) {
+                memcpy(column(_current, c, _capacity) + _scans, block.channels[c].data() + done,
+                    count * sizeof(int16_t));
+            }
+            _scans += count;
+            done += count;
+            if (_scans == _capacity) {
+                submitData();
+            }
+        }
+        return true;
+    }
+
+    // Closes the current chunk and records a configuration change, e.g. a
+    // new PGA setting or channel set; append() then expects its channels.
+    // Waits for a free buffer rather than lose the change.
+    bool writeConfig(const CaptureConfig &config) {
+        if (_fd < 0) {
+            return false;
+        }
+        if (_scans > 0) {
+            submitData();
+        }
+        while (!_current && !_free.tryPop(_current)) {
+            if (_failed.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        auto header = reinterpret_cast<CaptureChunkHeader *>(_current);
+        auto size = alignUp(sizeof(CaptureChunkHeader) + sizeof(CaptureConfig));
+        memset(_current, 0, size);
+        *header = {CAPTURE_CHUNK_MAGIC, CaptureChunkType::Config, config.channelCount, 0,
+            static_cast<uint32_t>(size), 0, 0};
+        memcpy(_current + sizeof(CaptureChunkHeader), &config, sizeof config);
+        submit();
+        setLayout(config);
+        return true;
+    }
+
+    // Flushes the last partial chunk, waits for the writer thread and
+    // appends the index. Same convention as ADS114S0XB::initialize():
+    // {errno, failing call}, also for a write that failed earlier.
+    std::pair<int, std::string> close() {
+        if (_fd < 0) {
+            return {0, ""};
+        }
+        if (_scans > 0) {
+            submitData();
+        }
+        wake(true);
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+
+        std::pair<int, std::string> status{0, ""};
+        if (_failed) {
+            status = {_lastErrno, "write"};
+        }
+        else if (!writeIndex()) {
+            status = {errno, "write index"};
+        }
+        else if (::fdatasync(_fd) < 0) {
+            status = {errno, "fdatasync"};
+        }
+        release();
+        return status;
+    }
+
+    bool isOpen() const {
+        return _fd >= 0;
+    }
+
+    uint64_t getDroppedScans() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getBytesWritten() const {
+        return _bytesWritten.load(std::memory_order_relaxed);
+    }
+
+    // Scans one chunk holds with the current channel count.
+    size_t getChunkScans() const {
+        return _capacity;
+    }
+
+private:
+    static constexpr size_t MAX_BATCH = 16;
+
+    CaptureWriterOptions _options;
+    int _fd = -1;
+    std::vector<uint8_t *> _buffers;
+    SpscRing<uint8_t *> _free; // writer thread -> append()
+    SpscRing<uint8_t *> _full; // append() -> writer thread
+    std::thread _thread;
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    std::atomic<bool> _stopping{false};
+    std::atomic<bool> _failed{false};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _bytesWritten{0};
+    int _lastErrno = 0;
+
+    // append() side
+    uint8_t *_current = nullptr;
+    size_t _scans = 0;
+    size_t _channels = 0;
+    size_t _capacity = 0;
+
+    // writer thread side
+    uint64_t _fileOffset = 0;
+    std::vector<CaptureIndexEntry> _index;
+
+    static size_t alignUp(size_t size) {
+        return (size + CAPTURE_ALIGNMENT - 1) & ~(CAPTURE_ALIGNMENT - 1);
+    }
+
+    static CaptureWriterOptions normalized(CaptureWriterOptions options) {
+        options.chunkBytes = alignUp(std::max(options.chunkBytes, CAPTURE_ALIGNMENT));
+        options.buffers = std::max<size_t>(options.buffers, 2);
+        return options;
+    }
+
+    static int64_t *timestamps(uint8_t *chunk) {
+        return reinterpret_cast<int64_t *>(chunk + sizeof(CaptureChunkHeader));
+    }
+
+    static int16_t *column(uint8_t *chunk, size_t c, size_t stride) {
+        return reinterpret_cast<int16_t *>(timestamps(chunk) + stride) + c * stride;
+    }
+
+    void setLayout(const CaptureConfig &config) {
+        _channels = config.channelCount;
+        _capacity = (_options.chunkBytes - sizeof(CaptureChunkHeader)) / (sizeof(int64_t) + _channels * sizeof(int16_t));
+    }
+
+    void submitData() {
+        auto stride = _capacity;
+        if (_scans < _capacity) {
+            // Partial chunk: close the gaps so columns sit at a stride of _scans
+            for (size_t c = 0; c < _channels; c++) {
+                memmove(column(_current, c, _scans), column(_current, c, stride), _scans * sizeof(int16_t));
+            }
+        }
+        auto used = sizeof(CaptureChunkHeader) + _scans * (sizeof(int64_t) + _channels * sizeof(int16_t));
+        auto size = alignUp(used);
+        memset(_current + used, 0, size - used);
+        auto ts = timestamps(_current);
+        *reinterpret_cast<CaptureChunkHeader *>(_current) = {CAPTURE_CHUNK_MAGIC, CaptureChunkType::Data,
+            static_cast<uint16_t>(_channels), static_cast<uint32_t>(_scans), static_cast<uint32_t>(size),
+            ts[0], ts[_scans - 1]};
+        submit();
+    }
+
+    // The ring holds every buffer, so the push cannot fail.
+    void submit() {
+        _full.tryPush(_current);
+        wake(false);
+        _current = nullptr;
+        _scans = 0;
+        _free.tryPop(_current);
+    }
+
+    // Taking the mutex once per chunk, not per append(), keeps the writer
+    // from missing a wakeup between its check and its wait.
+    void wake(bool stop) {
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            if (stop) {
+                _stopping = true;
+            }
+        }
+        _wakeCondition.notify_one();
+    }
+
+    void writerLoop() {
+        uint8_t *batch[MAX_BATCH];
+        for (;;) {
+            if (auto count = _full.tryPopBatch(batch, MAX_BATCH)) {
+                writeBatch(batch, count);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            if (_full.size() == 0 && _stopping) {
+                return;
+            }
+            _wakeCondition.wait(lock, [this] { return _full.size() > 0 || _stopping; });
+        }
+    }
+
+    void writeBatch(uint8_t **batch, size_t count) {
+        iovec iov[MAX_BATCH];
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) {
+            auto header = reinterpret_cast<const CaptureChunkHeader *>(batch[i]);
+            iov[i] = {batch[i], header->size};
+            total += header->size;
+        }
+        if (!_failed.load(std::memory_order_relaxed)) {
+            if (writeAll(iov, count, _fileOffset)) {
+                for (size_t i = 0; i < count; i++) {
+                    auto header = reinterpret_cast<const CaptureChunkHeader *>(batch[i]);
+                    _index.push_back({header->firstTimestamp, header->lastTimestamp, _fileOffset,
+                        header->scans, header->type, 0});
+                    _fileOffset += header->size;
+                }
+                _bytesWritten.fetch_add(total, std::memory_order_relaxed);
+            }
+            else {
+                _lastErrno = errno;
+                _failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        if (_failed.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i < count; i++) {
+                _dropped.fetch_add(reinterpret_cast<const CaptureChunkHeader *>(batch[i])->scans,
+                    std::memory_order_relaxed);
+            }
+        }
+        _free.tryPushBatch(batch, count);
+    }
+
+    bool writeAll(iovec *iov, size_t count, uint64_t offset) {
+        while (count > 0) {
+            auto ret = ::pwritev(_fd, iov, static_cast<int>(count), static_cast<off_t>(offset));
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            auto written = static_cast<size_t>(ret);
+            offset += written;
+            while (count > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+        return true;
+    }
+
+    // The index and trailer are not block sized, so O_DIRECT goes first.
+    bool writeIndex() {
+        if (_options.directIo) {
+            ::fcntl(_fd, F_SETFL, ::fcntl(_fd, F_GETFL) & ~O_DIRECT);
+        }
+        CaptureIndexTrailer trailer{};
+        memcpy(trailer.magic, CAPTURE_INDEX_MAGIC, sizeof trailer.magic);
+        trailer.entries = _index.size();
+        trailer.indexOffset = _fileOffset;
+        iovec iov[2] = {
+            {_index.data(), _index.size() * sizeof(CaptureIndexEntry)},
+            {&trailer, sizeof trailer},
+        };
+        return writeAll(iov, 2, _fileOffset);
+    }
+
+    // Releases everything without writing the index.
+    void release() {
+        if (_thread.joinable()) {
+            wake(true);
+            _thread.join();
+        }
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+        uint8_t *buffer;
+        while (_free.tryPop(buffer)) {
+        }
+        while (_full.tryPop(buffer)) {
+        }
+        for (auto b : _buffers) {
+            std::free(b);
+        }
+        _buffers.clear();
+        _current = nullptr;
+        _scans = 0;
+    }
+};
+
+// One DATA chunk, pointing into the mapped file.
+struct CaptureChunk {
+    int64_t firstTimestamp = 0;
+    int64_t lastTimestamp = 0;
+    size_t scans = 0;
+    size_t channels = 0;
+    size_t config = 0; // index into CaptureReader::configs()
+    const int64_t *timestampData = nullptr;
+    const int16_t *columnData = nullptr;
+
+    std::span<const int64_t> timestamps() const {
+        return {timestampData, scans};
+    }
+
+    std::span<const int16_t> column(size_t c) const {
+        return {columnData + c * scans, scans};
+    }
+
+    // Position of the first scan at or after timestamp, scans if none.
+    size_t lowerBound(int64_t timestamp) const {
+        return static_cast<size_t>(std::lower_bound(timestampData, timestampData + scans, timestamp) -
+            timestampData);
+    }
+};
+
+// Maps a capture file read-only. Finding a time takes a binary search over
+// the chunk index plus one within the chunk; only the pages touched are
+// read from disk.
+class CaptureReader {
+public:
+    CaptureReader() = default;
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    ~CaptureReader() {
+        close();
+    }
+
+    std::pair<int, std::string> open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return {errno, "open " + path};
+        }
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            auto err = errno;
+            ::close(fd);
+            return {err, "fstat " + path};
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size < CAPTURE_ALIGNMENT) {
+            ::close(fd);
+            return {EINVAL, "short capture file"};
+        }
+        auto data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            return {errno, "mmap " + path};
+        }
+        _data = static_cast<const uint8_t *>(data);
+
+        auto header = reinterpret_cast<const CaptureFileHeader *>(_data);
+        if (memcmp(header->magic, CAPTURE_MAGIC, sizeof header->magic) != 0 ||
+                header->version != CAPTURE_VERSION || header->alignment != CAPTURE_ALIGNMENT ||
+                header->config.channelCount > MAX_SCAN_CHANNELS) {
+            close();
+            return {EINVAL, "not a capture file"};
+        }
+        if (!loadIndex()) {
+            rebuildIndex();
+        }
+        return {0, ""};
+    }
+
+    void close() {
+        if (_data) {
+            ::munmap(const_cast<uint8_t *>(_data), _size);
+            _data = nullptr;
+        }
+        _size = 0;
+        _chunks.clear();
+        _configs.clear();
+        _indexed = false;
+    }
+
+    bool isOpen() const {
+        return _data != nullptr;
+    }
+
+    const CaptureFileHeader &header() const {
+        return *reinterpret_cast<const CaptureFileHeader *>(_data);
+    }
+
+    // The header's config first, then one per CONFIG chunk.
+    const std::vector<CaptureConfig> &configs() const {
+        return _configs;
+    }
+
+    size_t chunkCount() const {
+        return _chunks.size();
+    }
+
+    // The chunk header is only read here, so opening an indexed file does
+    // not touch the data chunks. A chunk whose header is damaged or does
+    // not match the index reads as empty.
+    CaptureChunk chunk(size_t i) const {
+        const auto &entry = _chunks[i];
+        CaptureChunk chunk;
+        chunk.firstTimestamp = entry.firstTimestamp;
+        chunk.lastTimestamp = entry.lastTimestamp;
+        chunk.config = entry.config;
+        auto header = chunkAt(entry.offset);
+        if (!header || header->type != CaptureChunkType::Data || header->scans != entry.scans ||
+                header->channels != _configs[entry.config].channelCount) {
+            return chunk;
+        }
+        chunk.scans = entry.scans;
+        chunk.channels = header->channels;
+        chunk.timestampData = reinterpret_cast<const int64_t *>(header + 1);
+        chunk.columnData = reinterpret_cast<const int16_t *>(chunk.timestampData + chunk.scans);
+        return chunk;
+    }
+
+    // First chunk whose last scan is at or after timestamp, chunkCount()
+    // if there is none.
+    size_t seek(int64_t timestamp) const {
+        return static_cast<size_t>(std::partition_point(_chunks.begin(), _chunks.end(),
+            [&](const CaptureIndexEntry &entry) { return entry.lastTimestamp < timestamp; }) - _chunks.begin());
+    }
+
+    uint64_t scanCount() const {
+        uint64_t scans = 0;
+        for (const auto &entry : _chunks) {
+            scans += entry.scans;
+        }
+        return scans;
+    }
+
+    // False when the file had no trailer and the index was rebuilt.
+    bool hasIndex() const {
+        return _indexed;
+    }
+
+private:
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+    std::vector<CaptureIndexEntry> _chunks; // DATA chunks only
+    std::vector<CaptureConfig> _configs;
+    bool _indexed = false;
+
+    // Chunk header at offset, if it is intact and inside the file.
+    const CaptureChunkHeader *chunkAt(uint64_t offset) const {
+        if (offset % CAPTURE_ALIGNMENT || offset + sizeof(CaptureChunkHeader) > _size) {
+            return nullptr;
+        }
+        auto header = reinterpret_cast<const CaptureChunkHeader *>(_data + offset);
+        if (header->magic != CAPTURE_CHUNK_MAGIC || header->size < sizeof(CaptureChunkHeader) ||
+                header->size % CAPTURE_ALIGNMENT || offset + header->size > _size) {
+            return nullptr;
+        }
+        size_t payload = header->type == CaptureChunkType::Config ? sizeof(CaptureConfig) :
+            header->scans * (sizeof(int64_t) + header->channels * sizeof(int16_t));
+        return sizeof(CaptureChunkHeader) + payload <= header->size ? header : nullptr;
+    }
+
+    // Returns false for a chunk that contradicts the config in force, or a
+    // config with more channels than channelIds holds.
+    bool addChunk(const CaptureChunkHeader *header, uint64_t offset) {
+        if (header->type == CaptureChunkType::Config) {
+            auto config = reinterpret_cast<const CaptureConfig *>(header + 1);
+            if (config->channelCount > MAX_SCAN_CHANNELS) {
+                return false;
+            }
+            _configs.push_back(*config);
+            return true;
+        }
+        if (header->type != CaptureChunkType::Data || header->channels != _configs.back().channelCount) {
+            return false;
+        }
+        if (header->scans > 0) {
+            _chunks.push_back({header->firstTimestamp, header->lastTimestamp, offset, header->scans,
+                CaptureChunkType::Data, static_cast<uint16_t>(_configs.size() - 1)});
+        }
+        return true;
+    }
+
+    bool loadIndex() {
+        _configs.assign(1, header().config);
+        _chunks.clear();
+        CaptureIndexTrailer trailer;
+        memcpy(&trailer, _data + _size - sizeof trailer, sizeof trailer);
+        if (memcmp(trailer.magic, CAPTURE_INDEX_MAGIC, sizeof trailer.magic) != 0 ||
+                trailer.indexOffset + trailer.entries * sizeof(CaptureIndexEntry) + sizeof trailer != _size) {
+            return false;
+        }
+        // DATA entries are taken as they are, chunk() checks the header;
+        // only CONFIG chunks are read
+        auto entries = reinterpret_cast<const CaptureIndexEntry *>(_data + trailer.indexOffset);
+        for (uint64_t i = 0; i < trailer.entries; i++) {
+            const auto &entry = entries[i];
+            if (entry.offset % CAPTURE_ALIGNMENT || entry.offset < CAPTURE_ALIGNMENT ||
+                    entry.offset >= trailer.indexOffset) {
+                return false;
+            }
+            if (entry.type == CaptureChunkType::Config) {
+                auto header = chunkAt(entry.offset);
+                if (!header || !addChunk(header, entry.offset)) {
+                    return false;
+                }
+            }
+            else if (entry.type != CaptureChunkType::Data) {
+                return false;
+            }
+            else if (entry.scans > 0) {
+                _chunks.push_back(entry);
+                _chunks.back().config = static_cast<uint16_t>(_configs.size() - 1);
+            }
+        }
+        _indexed = true;
+        return true;
+    }
+
+    // Walks the chunk headers up to the first damaged or missing one.
+    void rebuildIndex() {
+        _configs.assign(1, header().config);
+        _chunks.clear();
+        uint64_t offset = CAPTURE_ALIGNMENT;
+        while (auto header = chunkAt(offset)) {
+            if (!addChunk(header, offset)) {
+                break;
+            }
+            offset += header->size;
+        }
+        _indexed = false;
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <iio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ADS114S0XB.h"
+#include "AcquisitionEngine.h"
+
+namespace adcs
+{
+struct DeviceInfo {
+    std::string id;   // "iio:deviceN"
+    std::string name; // driver name of the part, "ads114s06b" or "ads114s08b"
+    ChipVariant chip = ChipVariant::ADS114S08B;
+};
+
+// One merged scan: values[] follows channelIds(device).
+struct DeviceScan {
+    size_t device;
+    ScanRecord scan;
+};
+
+struct DeviceManagerOptions {
+    size_t ringCapacity = 1 << 16; // per device
+    size_t samplesPerRead = 256;
+    std::vector<int> cpus;         // reader CPU of device i, -1 or missing: unpinned
+};
+
+// Several ADCs in one process, e.g. parts on different chip selects. Each
+// device gets its own source and AcquisitionEngine, so the readers scale
+// with the cores they are pinned to, and popMerged() interleaves their
+// scans into one stream ordered by timestamp (ties by device index).
+//
+// Configure every device (channels, registers) through device() before
+// start(). Exactly one thread may pop, as with AcquisitionEngine.
+class DeviceManager {
+public:
+    DeviceManager() = default;
+    DeviceManager(const DeviceManager &) = delete;
+    DeviceManager &operator=(const DeviceManager &) = delete;
+
+    ~DeviceManager() {
+        stop();
+    }
+
+    // Adds every device of the ads114s0xb driver found in the libiio
+    // context at uri (empty for the default), in device number order, each
+    // with its own LibiioBackend. Same convention as
+    // ADS114S0XB::initialize(): {errno, failing call}.
+    std::pair<int, std::string> discover(const std::string &uri = "", const std::string &trigger = "trigger0") {
+        auto ctx = uri.empty() ? iio_create_default_context() : iio_create_context_from_uri(uri.c_str());
+        if (!ctx) {
+            return {errno, uri.empty() ? "iio_create_default_context" : "iio_create_context_from_uri"};
+        }
+        std::vector<DeviceInfo> found;
+        for (unsigned int i = 0; i < iio_context_get_devices_count(ctx); i++) {
+            auto dev = iio_context_get_device(ctx, i);
+            auto name = iio_device_get_name(dev);
+            auto id = iio_device_get_id(dev);
+            if (!name || !id) {
+                continue;
+            }
+            if (!strcmp(name, "ads114s06b")) {
+                found.push_back({id, name, ChipVariant::ADS114S06B});
+            }
+            else if (!strcmp(name, "ads114s08b")) {
+                found.push_back({id, name, ChipVariant::ADS114S08B});
+            }
+        }
+        iio_context_destroy(ctx);
+        // iio:device10 after iio:device9
+        std::sort(found.begin(), found.end(), [](const DeviceInfo &a, const DeviceInfo &b) {
+            return a.id.size() != b.id.size() ? a.id.size() < b.id.size() : a.id < b.id;
+        });
+
+        for (auto &info : found) {
+            auto adc = std::make_unique<ADS114S0XB>(IIOSysfsFilesUtil(info.id, "", trigger));
+            if (auto status = adc->initialize(uri); status.first != 0) {
+                return {status.first, status.second + " " + info.id};
+            }
+            addDevice(std::move(adc), std::move(info));
+        }
+        return {0, ""};
+    }
+
+    // Any initialized device, e.g. on a SimulatedBackend. Returns its index.
+    size_t addDevice(std::unique_ptr<ADS114S0XB> adc, DeviceInfo info) {
+        auto lane = std::make_unique<Lane>();
+        lane->adc = std::move(adc);
+        lane->info = std::move(info);
+        _lanes.push_back(std::move(lane));
+        return _lanes.size() - 1;
+    }
+
+    size_t deviceCount() const {
+        return _lanes.size();
+    }
+
+    ADS114S0XB &device(size_t i) {
+        return *_lanes[i]->adc;
+    }
+
+    const DeviceInfo &info(size_t i) const {
+        return _lanes[i]->info;
+    }
+
+    // Valid between start() and the next start().
+    AcquisitionEngine &engine(size_t i) {
+        return *_lanes[i]->engine;
+    }
+
+    const std::vector<int> &channelIds(size_t i) const {
+        return _lanes[i]->engine->channelIds();
+    }
+
+    // Creates every device's source and starts its reader thread, pinned
+    // as options.cpus says. On failure nothing is left running.
+    std::pair<int, std::string> start(const DeviceManagerOptions &options = {}) {
+        stop();
+        for (size_t i = 0; i < _lanes.size(); i++) {
+            auto &lane = *_lanes[i];
+            lane.engine.reset();
+            lane.source = lane.adc->createSampleSource(options.samplesPerRead);
+            if (!lane.source) {
+                auto err = lane.adc->getLastErrno();
+                stop();
+                return {err, "createSampleSource " + lane.info.id};
+            }
+            lane.engine = std::make_unique<AcquisitionEngine>(*lane.source, options.ringCapacity,
+                options.samplesPerRead);
+            lane.engine->setMetrics(&lane.adc->getMetrics());
+            lane.pending.resize(std::max<size_t>(options.samplesPerRead, 64));
+            lane.head = lane.size = 0;
+            lane.done = false;
+        }
+        _heap.clear();
+        _refill.clear();
+        for (size_t i = 0; i < _lanes.size(); i++) {
+            _refill.push_back(i);
+            auto cpu = i < options.cpus.size() ? options.cpus[i] : -1;
+            if (auto err = _lanes[i]->engine->start(cpu); err != 0) {
+                stop();
+                return {err, "pthread_setaffinity_np " + _lanes[i]->info.id};
+            }
+        }
+        return {0, ""};
+    }
+
+    // Stops the readers and closes the sources; scans still queued can
+    // be popped until the next start().
+    void stop() {
+        for (auto &lane : _lanes) {
+            if (lane->engine) {
+                lane->engine->stop();
+            }
+        }
+        for (auto &lane : _lanes) {
+            lane->source.reset();
+        }
+    }
+
+    // True until every device's stream has ended and been merged.
+    bool isRunning() const {
+        return std::any_of(_lanes.begin(), _lanes.end(), [](const auto &lane) {
+            return lane->engine && !lane->done;
+        });
+    }
+
+    // Up to out.size() scans, oldest first. A scan is only handed out once
+    // every device still running has a scan in hand, so none can arrive
+    // later with an earlier timestamp; a device that stalls without ending
+    // stalls the merged stream as well.
+    size_t popMerged(std::span<DeviceScan> out) {
+        size_t count = 0;
+        while (count < out.size()) {
+            // Devices whose next scan is not in hand
+            for (size_t i = 0; i < _refill.size();) {
+                if (refill(_refill[i])) {
+                    _refill[i] = _refill.back();
+                    _refill.pop_back();
+                }
+                else {
+                    i++;
+                }
+            }
+            if (!_refill.empty() || _heap.empty()) {
+                break;
+            }
+
+            std::pop_heap(_heap.begin(), _heap.end(), std::greater<>());
+            auto device = _heap.back().second;
+            auto &lane = *_lanes[device];
+            out[count++] = {device, lane.pending[lane.head++]};
+            if (lane.head < lane.size) {
+                _heap.back().first = lane.pending[lane.head].timestamp;
+                std::push_heap(_heap.begin(), _heap.end(), std::greater<>());
+            }
+            else {
+                _heap.pop_back();
+                _refill.push_back(device);
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Lane {
+        std::unique_ptr<ADS114S0XB> adc;
+        DeviceInfo info;
+        std::unique_ptr<SampleSource> source;
+        std::unique_ptr<AcquisitionEngine> engine;
+        std::vector<ScanRecord> pending; // popped from the ring, not yet merged
+        size_t head = 0;
+        size_t size = 0;
+        bool done = false;
+    };
+
+    std::vector<std::unique_ptr<Lane>> _lanes;
+    std::vector<std::pair<int64_t, size_t>> _heap; // next timestamp of each device in hand
+    std::vector<size_t> _refill;
+
+    // True once the device has a scan in hand or its stream has ended.
+    bool refill(size_t device) {
+        auto &lane = *_lanes[device];
+        if (lane.done) {
+            return true;
+        }
+        // Read before popping: a reader that has stopped pushed everything
+        bool finished = !lane.engine->isRunning();
+        lane.head = 0;
+        lane.size = lane.engine->popBatch(std::span(lane.pending));
+        if (lane.size == 0) {
+            lane.done = finished;
+            return finished;
+        }
+        _heap.emplace_back(lane.pending[0].timestamp, device);
+        std::push_heap(_heap.begin(), _heap.end(), std::greater<>());
+        return true;
+    }
+};
+
+} // namespace adcs
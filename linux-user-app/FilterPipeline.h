@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "VoltageConverter.h"
+
+namespace adcs
+{
+namespace detail
+{
+// GCC vector extensions: one source for SSE/AVX and NEON, the compiler
+// splits or widens them to whatever the target has.
+using v4sf = float __attribute__((vector_size(16)));
+using v8sf = float __attribute__((vector_size(32)));
+
+inline float dot(const float *a, const float *b, size_t n) {
+    v8sf acc{};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        v8sf x, y;
+        std::memcpy(&x, a + i, sizeof x);
+        std::memcpy(&y, b + i, sizeof y);
+        acc += x * y;
+    }
+    float sum = 0.0f;
+    for (int k = 0; k < 8; k++) {
+        sum += acc[k];
+    }
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+inline float sum(const float *a, size_t n) {
+    v8sf acc{};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        v8sf x;
+        std::memcpy(&x, a + i, sizeof x);
+        acc += x;
+    }
+    float total = 0.0f;
+    for (int k = 0; k < 8; k++) {
+        total += acc[k];
+    }
+    for (; i < n; i++) {
+        total += a[i];
+    }
+    return total;
+}
+} // namespace detail
+
+// One stage of a FilterPipeline. setup() is the only call allowed to
+// allocate; process() filters every column of the block in place.
+class FilterStage {
+public:
+    virtual ~FilterStage() = default;
+
+    // Sizes the state for blocks of up to channels columns. maxBlock is a
+    // hint for the scratch space; larger blocks are processed in slices.
+    // More channels than setup() was given is a caller bug: the extra
+    // columns could not be filtered and would no longer line up with the
+    // decimated timestamps.
+    virtual void setup(size_t channels, size_t maxBlock) = 0;
+
+    // Clears the filter history, e.g. after a configuration change.
+    virtual void reset() = 0;
+
+    virtual void process(VoltageBlock &block) = 0;
+
+protected:
+    // Outputs of an R-fold decimator that has taken phase inputs since its
+    // last output land on inputs first, first + R, ... of the block. Each
+    // output keeps the timestamp of the input that completed it.
+    static size_t firstOutput(size_t decimation, size_t phase) {
+        return decimation - 1 - phase;
+    }
+
+    static size_t decimateTimestamps(VoltageBlock &block, size_t decimation, size_t phase) {
+        size_t outputs = 0;
+        for (size_t i = firstOutput(decimation, phase); i < block.size; i += decimation) {
+            block.timestamps[outputs++] = block.timestamps[i];
+        }
+        return outputs;
+    }
+
+    static size_t advance(size_t decimation, size_t phase, size_t n) {
+        return (phase + n) % decimation;
+    }
+};
+
+// Averages every R consecutive samples into one: a first-order CIC with
+// unity gain, the cheapest way to trade rate for noise.
+class BoxcarDecimator : public FilterStage {
+public:
+    explicit BoxcarDecimator(size_t decimation) :
+        _decimation(std::max<size_t>(decimation, 1)) {
+    }
+
+    void setup(size_t channels, size_t) override {
+        _partial.assign(channels, 0.0f);
+        _phase = 0;
+    }
+
+    void reset() override {
+        std::fill(_partial.begin(), _partial.end(), 0.0f);
+        _phase = 0;
+    }
+
+    void process(VoltageBlock &block) override {
+        assert(block.channelCount() <= _partial.size() && "more channels than given to setup()");
+        const float scale = 1.0f / static_cast<float>(_decimation);
+        size_t outputs = 0;
+        for (size_t c = 0; c < block.channelCount() && c < _partial.size(); c++) {
+            auto x = block.channels[c].data();
+            size_t i = 0;
+            size_t k = 0;
+            float acc = _partial[c];
+            // Finish the group left open by the previous block
+            for (size_t need = _decimation - _phase; i < block.size && need > 0; i++, need--) {
+                acc += x[i];
+            }
+            if (_phase + i == _decimation) {
+                x[k++] = acc * scale;
+                acc = 0.0f;
+                for (; i + _decimation <= block.size; i += _decimation) {
+                    x[k++] = detail::sum(x + i, _decimation) * scale;
+                }
+                for (; i < block.size; i++) {
+                    acc += x[i];
+                }
+            }
+            _partial[c] = acc;
+            outputs = k;
+        }
+        decimateTimestamps(block, _decimation, _phase);
+        _phase = advance(_decimation, _phase, block.size);
+        block.size = outputs;
+    }
+
+private:
+    size_t _decimation;
+    size_t _phase = 0;
+    std::vector<float> _partial;
+};
+
+// FIR filter that only evaluates the outputs a decimation by R keeps,
+// which is what the polyphase form saves: taps/R multiply-adds per input.
+// The history and the incoming block share one contiguous buffer per
+// channel so every output is a single vectorized dot product.
+class FirDecimator : public FilterStage {
+public:
+    FirDecimator(std::vector<float> taps, size_t decimation = 1) :
+        _reversed(taps.rbegin(), taps.rend()),
+        _decimation(std::max<size_t>(decimation, 1)) {
+        if (_reversed.empty()) {
+            _reversed.push_back(1.0f);
+        }
+    }
+
+    void setup(size_t channels, size_t maxBlock) override {
+        _stride = history() + std::max<size_t>(maxBlock, 1);
+        _work.assign(channels * _stride, 0.0f);
+        _channels = channels;
+        _phase = 0;
+    }
+
+    void reset() override {
+        std::fill(_work.begin(), _work.end(), 0.0f);
+        _phase = 0;
+    }
+
+    void process(VoltageBlock &block) override {
+        assert(block.channelCount() <= _channels && "more channels than given to setup()");
+        auto slice = _stride - history();
+        size_t outputs = 0;
+        for (size_t c = 0; c < block.channelCount() && c < _channels; c++) {
+            auto work = _work.data() + c * _stride;
+            auto x = block.channels[c].data();
+            size_t k = 0;
+            // Outputs are written behind the slice being read, never ahead
+            for (size_t done = 0; done < block.size;) {
+                auto n = std::min(block.size - done, slice);
+                std::memcpy(work + history(), x + done, n * sizeof(float));
+                auto phase = advance(_decimation, _phase, done);
+                for (size_t i = firstOutput(_decimation, phase); i < n; i += _decimation) {
+                    // work[i .. i + taps) ends on input done + i
+                    x[k++] = detail::dot(_reversed.data(), work + i, _reversed.size());
+                }
+                std::memmove(work, work + n, history() * sizeof(float));
+                done += n;
+            }
+            outputs = k;
+        }
+        decimateTimestamps(block, _decimation, _phase);
+        _phase = advance(_decimation, _phase, block.size);
+        block.size = outputs;
+    }
+
+    size_t taps() const {
+        return _reversed.size();
+    }
+
+private:
+    std::vector<float> _reversed;
+    size_t _decimation;
+    size_t _phase = 0;
+    size_t _channels = 0;
+    size_t _stride = 0;
+    std::vector<float> _work;
+
+    size_t history() const {
+        return _reversed.size() - 1;
+    }
+};
+
+// CIC (sinc^order) decimator with unity DC gain. Run as its equivalent FIR
+// so float samples need no wrapping integer integrators.
+class CicDecimator : public FirDecimator {
+public:
+    CicDecimator(size_t decimation, unsigned order) :
+        FirDecimator(cicTaps(decimation, order), decimation) {
+    }
+
+    static std::vector<float> cicTaps(size_t decimation, unsigned order) {
+        decimation = std::max<size_t>(decimation, 1);
+        std::vector<double> taps{1.0};
+        for (unsigned o = 0; o < order; o++) {
+            std::vector<double> next(taps.size() + decimation - 1, 0.0);
+            for (size_t i = 0; i < taps.size(); i++) {
+                for (size_t j = 0; j < decimation; j++) {
+                    next[i + j] += taps[i];
+                }
+            }
+            taps = std::move(next);
+        }
+        double gain = std::pow(static_cast<double>(decimation), order);
+        std::vector<float> result(taps.size());
+        for (size_t i = 0; i < taps.size(); i++) {
+            result[i] = static_cast<float>(taps[i] / gain);
+        }
+        return result;
+    }
+};
+
+// Normalised (a0 = 1) second-order section, with the RBJ cookbook designs.
+struct Biquad {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    static Biquad lowpass(double cutoff, double rate, double q = M_SQRT1_2) {
+        auto [cosw, alpha] = prewarp(cutoff, rate, q);
+        return normalise((1 - cosw) / 2, 1 - cosw, (1 - cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha);
+    }
+
+    static Biquad highpass(double cutoff, double rate, double q = M_SQRT1_2) {
+        auto [cosw, alpha] = prewarp(cutoff, rate, q);
+        return normalise((1 + cosw) / 2, -(1 + cosw), (1 + cosw) / 2, 1 + alpha, -2 * cosw, 1 - alpha);
+    }
+
+    // Mains rejection: notch(50.0, rate) or notch(60.0, rate).
+    static Biquad notch(double center, double rate, double q = 10.0) {
+        auto [cosw, alpha] = prewarp(center, rate, q);
+        return normalise(1, -2 * cosw, 1, 1 + alpha, -2 * cosw, 1 - alpha);
+    }
+
+private:
+    static std::pair<double, double> prewarp(double frequency, double rate, double q) {
+        double w0 = 2 * M_PI * frequency / rate;
+        return {std::cos(w0), std::sin(w0) / (2 * q)};
+    }
+
+    static Biquad normalise(double b0, double b1, double b2, double a0, double a1, double a2) {
+        return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0),
+            static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)};
+    }
+};
+
+// Cascade of biquads in transposed direct form II. The recursion is serial
+// in time, so the SIMD lanes run four channels side by side instead.
+class BiquadCascade : public FilterStage {
+public:
+    explicit BiquadCascade(std::vector<Biquad> sections) :
+        _sections(std::move(sections)) {
+    }
+
+    void setup(size_t channels, size_t) override {
+        _channels = channels;
+        _state.assign(groups() * _sections.size() * 2, detail::v4sf{});
+    }
+
+    void reset() override {
+        std::fill(_state.begin(), _state.end(), detail::v4sf{});
+    }
+
+    void process(VoltageBlock &block) override {
+        auto channels = std::min(block.channelCount(), _channels);
+        for (size_t g = 0; g * LANES < channels; g++) {
+            float *lane[LANES];
+            size_t active = std::min(LANES, channels - g * LANES);
+            for (size_t l = 0; l < LANES; l++) {
+                lane[l] = l < active ? block.channels[g * LANES + l].data() : nullptr;
+            }
+            auto state = _state.data() + g * _sections.size() * 2;
+            for (size_t i = 0; i < block.size; i++) {
+                detail::v4sf x{};
+                for (size_t l = 0; l < active; l++) {
+                    x[l] = lane[l][i];
+                }
+                for (size_t s = 0; s < _sections.size(); s++) {
+                    const auto &q = _sections[s];
+                    auto &z1 = state[2 * s];
+                    auto &z2 = state[2 * s + 1];
+                    auto y = q.b0 * x + z1;
+                    z1 = q.b1 * x - q.a1 * y + z2;
+                    z2 = q.b2 * x - q.a2 * y;
+                    x = y;
+                }
+                for (size_t l = 0; l < active; l++) {
+                    lane[l][i] = x[l];
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr size_t LANES = 4;
+    std::vector<Biquad> _sections;
+    size_t _channels = 0;
+    std::vector<detail::v4sf> _state;
+
+    size_t groups() const {
+        return (_channels + LANES - 1) / LANES;
+    }
+};
+
+// Ordered chain of stages applied to converted blocks between the
+// AcquisitionEngine and the consumers:
+//
+//   FilterPipeline filters;
+//   filters.add<BiquadCascade>(std::vector{Biquad::notch(50, 4000)});
+//   filters.add<CicDecimator>(8, 3);
+//   filters.setup(volts);            // allocates, once
+//   filters.process(volts);          // per block, in place, no allocation
+class FilterPipeline {
+public:
+    template <typename Stage, typename... Args>
+    Stage &add(Args &&...args) {
+        auto stage = std::make_unique<Stage>(std::forward<Args>(args)...);
+        auto &ref = *stage;
+        _stages.push_back(std::move(stage));
+        return ref;
+    }
+
+    void setup(size_t channels, size_t maxBlock) {
+        for (auto &stage : _stages) {
+            stage->setup(channels, maxBlock);
+        }
+    }
+
+    void setup(const VoltageBlock &block) {
+        setup(block.channelCount(), block.capacity());
+    }
+
+    void reset() {
+        for (auto &stage : _stages) {
+            stage->reset();
+        }
+    }
+
+    // Returns the number of scans left in block after decimation.
+    size_t process(VoltageBlock &block) {
+        for (auto &stage : _stages) {
+            stage->process(block);
+        }
+        return block.size;
+    }
+
+    size_t stageCount() const {
+        return _stages.size();
+    }
+
+private:
+    std::vector<std::unique_ptr<FilterStage>> _stages;
+};
+
+} // namespace adcs
@@ -8,14 +8,26 @@ public:
 	IIOSysfsFilesUtil() : IIOSysfsFilesUtil(DEFAULT_IIO_DEVICE_NAME) {
 	}
 	
-	IIOSysfsFilesUtil(const std::string &deviceId) : 
+	// rootDir prefixes every absolute path, so a fake sysfs/dev tree
+	// (e.g. for benchmarks) can stand in for the real one. triggerId is
+	// the sysfs trigger whose trigger_now starts a conversion; several
+	// devices may share one.
+	IIOSysfsFilesUtil(const std::string &deviceId, const std::string &rootDir = "",
+			const std::string &triggerId = DEFAULT_IIO_TRIGGER_NAME) : 
 		IIO_DEVICE_NAME(deviceId),
-		SYSFS_BUFFER_INTERFACE("/dev/" + IIO_DEVICE_NAME),
-		SYSFS_TRIGGER("/sys/bus/iio/devices/" + SYSFS_TRIGGER_INSTANCE + "/trigger_now") {
+		ROOT_DIR(rootDir),
+		SYSFS_DEVICE_DIR(ROOT_DIR + "/sys/bus/iio/devices/" + IIO_DEVICE_NAME + "/"),
+		SYSFS_BUFFER_INTERFACE(ROOT_DIR + "/dev/" + IIO_DEVICE_NAME),
+		SYSFS_TRIGGER_INSTANCE(triggerId),
+		SYSFS_TRIGGER(ROOT_DIR + "/sys/bus/iio/devices/" + SYSFS_TRIGGER_INSTANCE + "/trigger_now") {
 	}
 
 	const std::string& getIIODeviceName() const { return IIO_DEVICE_NAME; }
+	const std::string& getRootDir() const { return ROOT_DIR; }
+	const std::string& getDeviceDir() const { return SYSFS_DEVICE_DIR; }
 	const std::string& getBufferEnable() const { return SYSFS_BUFFER_ENABLE; }
+	const std::string& getBufferLength() const { return SYSFS_BUFFER_LENGTH; }
+	const std::string& getBufferWatermark() const { return SYSFS_BUFFER_WATERMARK; }
 	const std::string& getBufferInterface() const { return SYSFS_BUFFER_INTERFACE; }
 	const std::string& getTriggerInstance() const { return SYSFS_TRIGGER_INSTANCE; }
 	const std::string& getScanVoltage() const { return SYSFS_SCAN_VOLTAGE; }
@@ -26,15 +38,32 @@ public:
 	std::string getVoltageEnable(int channel) const {
 		return SYSFS_SCAN_VOLTAGE + std::to_string(channel) + SYSFS_ENABLE_ID;
 	}
+	std::string getScanElementsDir() const {
+		return SYSFS_DEVICE_DIR + SYSFS_SCAN_ELEMENTS;
+	}
+	std::string getRegisterMap() const {
+		return SYSFS_DEVICE_DIR + SYSFS_REGISTER_MAP;
+	}
+	std::string getCalibrationTable() const {
+		return SYSFS_DEVICE_DIR + SYSFS_CALIBRATION_TABLE;
+	}
 
 private:
-	const std::string DEFAULT_IIO_DEVICE_NAME{"iio:device0"};
+	static constexpr const char *DEFAULT_IIO_DEVICE_NAME{"iio:device0"};
+	static constexpr const char *DEFAULT_IIO_TRIGGER_NAME{"trigger0"};
 	const std::string IIO_DEVICE_NAME; 
+	const std::string ROOT_DIR;
+	const std::string SYSFS_DEVICE_DIR;
 	const std::string SYSFS_BUFFER_ENABLE{"buffer/enable"};
+	const std::string SYSFS_BUFFER_LENGTH{"buffer/length"};
+	const std::string SYSFS_BUFFER_WATERMARK{"buffer/watermark"};
 	const std::string SYSFS_BUFFER_INTERFACE;
-	const std::string SYSFS_TRIGGER_INSTANCE{"trigger0"};
+	const std::string SYSFS_TRIGGER_INSTANCE;
+	const std::string SYSFS_SCAN_ELEMENTS{"scan_elements/"};
 	const std::string SYSFS_SCAN_VOLTAGE{"scan_elements/in_voltage"};
 	const std::string SYSFS_ENABLE_ID{"_en"};
+	const std::string SYSFS_REGISTER_MAP{"registers"};
+	const std::string SYSFS_CALIBRATION_TABLE{"calibration"};
 	const std::string SYSFS_TRIGGER;
 	const std::string SYSFS_FLAG_ON{"1"};
 	const std::string SYSFS_FLAG_OFF{"0"};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <iio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Metrics.h"
+#include "SampleSource.h"
+
+namespace adcs
+{
+// Buffered acquisition through libiio: the kernel batches samplesPerRefill
+// scans per iio_buffer_refill(), and decoding walks the buffer with
+// iio_buffer_first()/iio_buffer_step(). Works unchanged on a local context,
+// a remote iiod ("ip:host") or an XML stand-in context. cyclic is handed
+// to libiio as is; the kernel only honours it on output buffers.
+class IioBufferAcquisition : public SampleSource {
+public:
+    IioBufferAcquisition(struct iio_device *dev, size_t samplesPerRefill, bool cyclic = false) :
+        _dev(dev),
+        _samplesPerRefill(samplesPerRefill),
+        _cyclic(cyclic) {
+    }
+
+    IioBufferAcquisition(const IioBufferAcquisition &) = delete;
+    IioBufferAcquisition &operator=(const IioBufferAcquisition &) = delete;
+
+    ~IioBufferAcquisition() {
+        stop();
+    }
+
+    // Enables the given voltage channels (and the timestamp, if the device
+    // has one) and creates the buffer, which also enables it in the kernel.
+    std::pair<int, std::string> start(const std::vector<int> &channels) {
+        if (_buffer != nullptr) {
+            return {0, "already started"};
+        }
+        if (!_dev) {
+            return {ENODEV, "iio_device"};
+        }
+        _channels.clear();
+        _channelIds.clear();
+        for (auto channel : channels) {
+            auto name = "voltage" + std::to_string(channel);
+            auto chn = iio_device_find_channel(_dev, name.c_str(), false);
+            if (!chn) {
+                return {ENOENT, "iio_device_find_channel " + name};
+            }
+            iio_channel_enable(chn);
+            _channels.push_back(chn);
+            _channelIds.push_back(channel);
+        }
+        _timestamp = iio_device_find_channel(_dev, "timestamp", false);
+        if (_timestamp) {
+            iio_channel_enable(_timestamp);
+        }
+
+        _buffer = iio_device_create_buffer(_dev, _samplesPerRefill, _cyclic);
+        if (!_buffer) {
+            auto err = errno;
+            disableChannels();
+            return {err, "iio_device_create_buffer"};
+        }
+        return {0, ""};
+    }
+
+    void stop() {
+        if (_buffer != nullptr) {
+            iio_buffer_destroy(_buffer);
+            _buffer = nullptr;
+            disableChannels();
+        }
+    }
+
+    void prepare(SampleBlock &block) const {
+        block.reset(_channelIds, _samplesPerRefill);
+    }
+
+    // A refill is never split, so blocks hold at least samplesPerRefill.
+    void prepare(SampleBlock &block, size_t capacity) override {
+        block.reset(_channelIds, std::max(capacity, _samplesPerRefill));
+    }
+
+    ssize_t read(SampleBlock &block) override {
+        auto ret = refill(block);
+        if (ret < 0) {
+            errno = static_cast<int>(-ret);
+        }
+        return ret;
+    }
+
+    // The refill counts as the read syscall, the conversion loop as decode.
+    void setMetrics(Metrics *metrics) override {
+        _metrics = metrics;
+    }
+
+    // Blocks until the kernel has a full refill, then converts it into
+    // block. Returns the number of scans, or -errno.
+    ssize_t refill(SampleBlock &block) {
+        bool instrumented = METRICS_ENABLED && _metrics;
+        auto start = instrumented ? metricsNow() : 0;
+        auto ret = iio_buffer_refill(_buffer);
+        if (ret < 0) {
+            block.size = 0;
+            if (instrumented) {
+                _metrics->readErrors.add();
+            }
+            return ret;
+        }
+        if (instrumented) {
+            auto now = metricsNow();
+            _metrics->readSyscall.record(static_cast<uint64_t>(now - start));
+            _metrics->reads.add();
+            _metrics->bytesRead.add(static_cast<uint64_t>(ret));
+            start = now;
+        }
+
+        auto step = iio_buffer_step(_buffer);
+        auto end = static_cast<const uint8_t *>(iio_buffer_end(_buffer));
+        size_t scans = 0;
+        for (size_t c = 0; c < _channels.size(); c++) {
+            auto ptr = static_cast<const uint8_t *>(iio_buffer_first(_buffer, _channels[c]));
+            auto column = block.channels[c].data();
+            for (scans = 0; ptr < end && scans < block.capacity(); ptr += step, scans++) {
+                iio_channel_convert(_channels[c], &column[scans], ptr);
+            }
+        }
+        if (_timestamp) {
+            auto ptr = static_cast<const uint8_t *>(iio_buffer_first(_buffer, _timestamp));
+            size_t i = 0;
+            for (; ptr < end && i < block.capacity(); ptr += step, i++) {
+                iio_channel_convert(_timestamp, &block.timestamps[i], ptr);
+            }
+            scans = _channels.empty() ? i : scans;
+        }
+        block.size = scans;
+        if (instrumented) {
+            _metrics->decode.recordSince(start);
+            _metrics->scansDecoded.add(scans);
+        }
+        return static_cast<ssize_t>(scans);
+    }
+
+    // Descriptor that becomes readable when a refill would not block.
+    int getPollFd() const {
+        return _buffer ? iio_buffer_get_poll_fd(_buffer) : -1;
+    }
+
+    size_t getSamplesPerRefill() const {
+        return _samplesPerRefill;
+    }
+
+    bool isCyclic() const {
+        return _cyclic;
+    }
+
+private:
+    struct iio_device *_dev = nullptr;
+    struct iio_buffer *_buffer = nullptr;
+    struct iio_channel *_timestamp = nullptr;
+    std::vector<struct iio_channel *> _channels;
+    std::vector<int> _channelIds;
+    size_t _samplesPerRefill;
+    bool _cyclic;
+    Metrics *_metrics = nullptr;
+
+    void disableChannels() {
+        for (auto chn : _channels) {
+            iio_channel_disable(chn);
+        }
+        if (_timestamp) {
+            iio_channel_disable(_timestamp);
+        }
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <iio.h>
+
+#include "IioBufferAcquisition.h"
+#include "SysfsBackend.h"
+
+namespace adcs
+{
+// The kernel driver through libiio, which also reaches remote devices
+// over iiod. Burst register access and the scan layout still go through
+// the sysfs files, as libiio has no equivalent.
+class LibiioBackend : public SysfsBackend {
+public:
+    explicit LibiioBackend(const IIOSysfsFilesUtil &iioSysfs = IIOSysfsFilesUtil()) :
+        SysfsBackend(iioSysfs) {
+    }
+
+    LibiioBackend(const LibiioBackend &) = delete;
+    LibiioBackend &operator=(const LibiioBackend &) = delete;
+
+    ~LibiioBackend() override {
+        if (_ctx != nullptr) {
+            iio_context_destroy(_ctx);
+        }
+    }
+
+    std::pair<int, std::string> open(const std::string &uri = "") override {
+        if (_ctx != nullptr) {
+            return {0, "already initialized"};
+        }
+        if (uri.empty()) {
+            _ctx = iio_create_default_context();
+            if (!_ctx) {
+                return {errno, "iio_create_default_context"};
+            }
+        }
+        else {
+            _ctx = iio_create_context_from_uri(uri.c_str());
+            if (!_ctx) {
+                return {errno, "iio_create_context_from_uri"};
+            }
+        }
+        return findDevices();
+    }
+
+    std::optional<std::string> readAttribute(const std::string &name) override {
+        if (!_dev) {
+            return std::nullopt;
+        }
+        char buf[128];
+        auto ret = iio_device_attr_read(_dev, name.c_str(), buf, sizeof buf);
+        if (ret < 0) {
+            _last_errno = static_cast<int>(-ret);
+            return std::nullopt;
+        }
+        return std::string(buf);
+    }
+
+    bool writeAttribute(const std::string &name, const std::string &value) override {
+        if (!_dev) {
+            return false;
+        }
+        auto ret = iio_device_attr_write(_dev, name.c_str(), value.c_str());
+        if (ret < 0) {
+            _last_errno = static_cast<int>(-ret);
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<long long> readAttributeValue(const std::string &name) override {
+        long long value;
+        if (!_dev) {
+            return std::nullopt;
+        }
+        if (auto ret = iio_device_attr_read_longlong(_dev, name.c_str(), &value); ret < 0) {
+            _last_errno = -ret;
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    bool writeAttributeValue(const std::string &name, long long value) override {
+        if (!_dev) {
+            return false;
+        }
+        if (auto ret = iio_device_attr_write_longlong(_dev, name.c_str(), value); ret < 0) {
+            _last_errno = -ret;
+            return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<SampleSource> createSampleSource(const std::vector<int> &channels,
+            size_t samplesPerRead) override {
+        auto source = std::make_unique<IioBufferAcquisition>(_dev, samplesPerRead);
+        if (auto status = source->start(channels); status.first != 0) {
+            _last_errno = status.first;
+            return nullptr;
+        }
+        return source;
+    }
+
+    struct iio_device *getIioDevice() const override {
+        return _dev;
+    }
+
+private:
+    struct iio_context *_ctx = nullptr;
+    struct iio_device *_dev = nullptr;
+    struct iio_device *_trigger = nullptr;
+
+    std::pair<int, std::string> findDevices() {
+        _dev = iio_context_find_device(_ctx, _iioSysfs.getIIODeviceName().c_str());
+        if (!_dev) {
+            iio_context_destroy(_ctx);
+            _ctx = nullptr;
+            return {errno, "iio_create_default_context"};
+        }
+
+        _trigger = iio_context_find_device(_ctx, _iioSysfs.getTriggerInstance().c_str());
+        if (!_trigger) {
+            iio_context_destroy(_ctx);
+            _ctx = nullptr;
+            _dev = nullptr;
+            return {errno, "iio_create_default_context, trigger"};
+        }
+        return {0,""};
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace adcs
+{
+// Built with -DADS114S0XB_NO_METRICS every recording call below compiles
+// to nothing, clock reads included.
+#ifdef ADS114S0XB_NO_METRICS
+static constexpr bool METRICS_ENABLED = false;
+#else
+static constexpr bool METRICS_ENABLED = true;
+#endif
+
+// Monotonic nanoseconds for the hot path, or 0 with metrics compiled out.
+inline int64_t metricsNow() {
+    if constexpr (METRICS_ENABLED) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    return 0;
+}
+
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        if constexpr (METRICS_ENABLED) {
+            _value.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t value() const {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> _value{0};
+};
+
+// Copy of a LatencyHistogram; all the queries live here so readers never
+// walk the live atomics twice.
+struct HistogramSnapshot {
+    static constexpr unsigned SUB_BITS = 4;                     // 16 buckets per octave, ~6%
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;                    // ~18 minutes in ns
+    // bucketOf() clamps to (1 << MAX_BITS) - 1, which lands in the last one
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::array<uint64_t, BUCKETS> buckets{};
+
+    // Log-linear bucketing as in HdrHistogram: values below SUB_COUNT are
+    // exact, above that every power of two splits into SUB_COUNT buckets.
+    static size_t bucketOf(uint64_t value) {
+        value = std::min<uint64_t>(value, (1ull << MAX_BITS) - 1);
+        unsigned msb = value ? 63 - __builtin_clzll(value) : 0;
+        unsigned shift = msb > SUB_BITS ? msb - SUB_BITS : 0;
+        return shift * SUB_COUNT + (value >> shift);
+    }
+
+    // Midpoint of the values that land in bucket.
+    static uint64_t valueOf(size_t bucket) {
+        if (bucket < 2 * SUB_COUNT) {
+            return bucket;
+        }
+        unsigned shift = static_cast<unsigned>(bucket / SUB_COUNT) - 1;
+        uint64_t low = (bucket - shift * SUB_COUNT) << shift;
+        return low + ((1ull << shift) >> 1);
+    }
+
+    double mean() const {
+        return count ? static_cast<double>(sum) / count : 0.0;
+    }
+
+    // q in [0, 1]
+    uint64_t percentile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min<uint64_t>(valueOf(i), max);
+            }
+        }
+        return max;
+    }
+};
+
+// Lock-free latency histogram in nanoseconds: one relaxed increment per
+// sample plus the sum, so writers on several threads never contend on
+// more than a cache line.
+class LatencyHistogram {
+public:
+    void record(uint64_t ns) {
+        if constexpr (METRICS_ENABLED) {
+            _buckets[HistogramSnapshot::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+            _count.fetch_add(1, std::memory_order_relaxed);
+            _sum.fetch_add(ns, std::memory_order_relaxed);
+            auto max = _max.load(std::memory_order_relaxed);
+            while (ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    // Records the time since start (a metricsNow() value).
+    void recordSince(int64_t start) {
+        if constexpr (METRICS_ENABLED) {
+            record(static_cast<uint64_t>(metricsNow() - start));
+        }
+    }
+
+    // Not atomic as a whole: a record() racing with it may show up in the
+    // buckets but not yet in count, which percentile() tolerates.
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot s;
+        for (size_t i = 0; i < s.buckets.size(); i++) {
+            s.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        }
+        s.count = _count.load(std::memory_order_relaxed);
+        s.sum = _sum.load(std::memory_order_relaxed);
+        s.max = _max.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::BUCKETS> _buckets{};
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _sum{0};
+    std::atomic<uint64_t> _max{0};
+};
+
+struct MetricsSnapshot {
+    uint64_t triggers = 0;
+    uint64_t triggerErrors = 0;
+    uint64_t reads = 0;
+    uint64_t readErrors = 0;
+    uint64_t shortReads = 0;
+    uint64_t bytesRead = 0;
+    uint64_t scansDecoded = 0;
+    uint64_t overruns = 0;
+    HistogramSnapshot triggerToData;
+    HistogramSnapshot readSyscall;
+    HistogramSnapshot decode;
+    HistogramSnapshot queueResidency;
+};
+
+// Per-device instrumentation shared by the pieces of one acquisition:
+// StreamingSession and IioBufferAcquisition record the trigger, read and
+// decode stages, AcquisitionEngine the overruns and how long scans wait in
+// its ring. Attach with setMetrics(); a null pointer turns it off at run
+// time, ADS114S0XB_NO_METRICS at compile time.
+class Metrics {
+public:
+    Counter triggers;
+    Counter triggerErrors;
+    Counter reads;
+    Counter readErrors;
+    Counter shortReads;      // read returned less than asked for
+    Counter bytesRead;
+    Counter scansDecoded;
+    Counter overruns;        // scans dropped because the ring was full
+    LatencyHistogram triggerToData;  // trigger write done -> read returned data
+    LatencyHistogram readSyscall;
+    LatencyHistogram decode;
+    LatencyHistogram queueResidency; // push into the ring -> popped by the consumer
+
+    MetricsSnapshot snapshot() const {
+        MetricsSnapshot s;
+        s.triggers = triggers.value();
+        s.triggerErrors = triggerErrors.value();
+        s.reads = reads.value();
+        s.readErrors = readErrors.value();
+        s.shortReads = shortReads.value();
+        s.bytesRead = bytesRead.value();
+        s.scansDecoded = scansDecoded.value();
+        s.overruns = overruns.value();
+        s.triggerToData = triggerToData.snapshot();
+        s.readSyscall = readSyscall.snapshot();
+        s.decode = decode.snapshot();
+        s.queueResidency = queueResidency.snapshot();
+        return s;
+    }
+
+    // Prometheus text exposition format, e.g. for node_exporter's textfile
+    // collector. labels is inserted verbatim, e.g. device="iio:device0".
+    // Written to a temporary file and renamed so scrapers never see half a
+    // file. Returns false with errno set on failure.
+    bool writePrometheus(const std::string &path, const std::string &labels = "") const {
+        auto tmp = path + ".tmp";
+        FILE *out = fopen(tmp.c_str(), "w");
+        if (!out) {
+            return false;
+        }
+        auto s = snapshot();
+        auto counter = [&](const char *name, const char *help, uint64_t value) {
+            fprintf(out, "# HELP ads114s0xb_%s %s\n# TYPE ads114s0xb_%s counter\n", name, help, name);
+            fprintf(out, "ads114s0xb_%s{%s} %" PRIu64 "\n", name, labels.c_str(), value);
+        };
+        auto summary = [&](const char *name, const char *help, const HistogramSnapshot &h) {
+            fprintf(out, "# HELP ads114s0xb_%s %s\n# TYPE ads114s0xb_%s summary\n", name, help, name);
+            const char *sep = labels.empty() ? "" : ",";
+            for (double q : {0.5, 0.9, 0.99, 0.999}) {
+                fprintf(out, "ads114s0xb_%s{%s%squantile=\"%g\"} %.9f\n",
+                    name, labels.c_str(), sep, q, h.percentile(q) / 1e9);
+            }
+            fprintf(out, "ads114s0xb_%s_sum{%s} %.9f\n", name, labels.c_str(), h.sum / 1e9);
+            fprintf(out, "ads114s0xb_%s_count{%s} %" PRIu64 "\n", name, labels.c_str(), h.count);
+        };
+        counter("triggers_total", "Conversions triggered through sysfs.", s.triggers);
+        counter("trigger_errors_total", "Failed trigger writes.", s.triggerErrors);
+        counter("reads_total", "Buffer reads that returned data.", s.reads);
+        counter("read_errors_total", "Failed buffer reads.", s.readErrors);
+        counter("short_reads_total", "Buffer reads that returned less than requested.", s.shortReads);
+        counter("read_bytes_total", "Bytes read from the buffer.", s.bytesRead);
+        counter("scans_decoded_total", "Scans decoded into sample blocks.", s.scansDecoded);
+        counter("overruns_total", "Scans dropped because the acquisition ring was full.", s.overruns);
+        summary("trigger_to_data_seconds", "Trigger write to data available.", s.triggerToData);
+        summary("read_syscall_seconds", "Time spent in the buffer read.", s.readSyscall);
+        summary("decode_seconds", "Time spent decoding a read.", s.decode);
+        summary("queue_residency_seconds", "Time scans wait in the acquisition ring.", s.queueResidency);
+
+        bool ok = fflush(out) == 0;
+        ok = fclose(out) == 0 && ok;
+        return ok && rename(tmp.c_str(), path.c_str()) == 0;
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,415 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace adcs
+{
+namespace detail
+{
+// Frames of a coroutine read loop come and go at the same few sizes, so
+// each thread keeps a handful per size to spare the loop a malloc per read.
+class FrameCache {
+public:
+    ~FrameCache() {
+        for (size_t c = 0; c < CLASSES; c++) {
+            while (_counts[c] > 0) {
+                ::operator delete(_frames[c][--_counts[c]]);
+            }
+        }
+    }
+
+    void *allocate(size_t size) {
+        auto c = sizeClass(size);
+        if (c < CLASSES && _counts[c] > 0) {
+            return _frames[c][--_counts[c]];
+        }
+        return ::operator new(c < CLASSES ? c * GRANULE : size);
+    }
+
+    void release(void *frame, size_t size) {
+        auto c = sizeClass(size);
+        if (c < CLASSES && _counts[c] < DEPTH) {
+            _frames[c][_counts[c]++] = frame;
+            return;
+        }
+        ::operator delete(frame);
+    }
+
+private:
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t CLASSES = 32; // frames up to 2 KiB
+    static constexpr size_t DEPTH = 8;
+
+    void *_frames[CLASSES][DEPTH];
+    size_t _counts[CLASSES] = {};
+
+    static size_t sizeClass(size_t size) {
+        return (size + GRANULE - 1) / GRANULE;
+    }
+};
+
+inline thread_local FrameCache frameCache;
+
+template <typename T>
+struct TaskResult {
+    std::optional<T> value;
+
+    void return_value(T result) {
+        value = std::move(result);
+    }
+
+    T take() {
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskResult<void> {
+    void return_void() {
+    }
+
+    void take() {
+    }
+};
+} // namespace detail
+
+// Lazily started coroutine returning T. Awaiting it runs it until it
+// completes (or suspends on I/O), then resumes the awaiter directly.
+// Top-level tasks are started with Reactor::spawn().
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    struct promise_type : detail::TaskResult<T> {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct Resume {
+                bool await_ready() noexcept {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                    auto next = self.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() noexcept {
+                }
+            };
+            return Resume{};
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        static void *operator new(size_t size) {
+            return detail::frameCache.allocate(size);
+        }
+
+        static void operator delete(void *frame, size_t size) {
+            detail::frameCache.release(frame, size);
+        }
+    };
+
+    Task(Task &&other) noexcept :
+        _handle(std::exchange(other._handle, nullptr)) {
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (_handle) {
+                _handle.destroy();
+            }
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        _handle.promise().continuation = awaiter;
+        return _handle;
+    }
+
+    T await_resume() {
+        if (_handle.promise().exception) {
+            std::rethrow_exception(_handle.promise().exception);
+        }
+        return _handle.promise().take();
+    }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) :
+        _handle(handle) {
+    }
+};
+
+// A descriptor watched by a Reactor. Registered once, edge-triggered: the
+// owner reads until EAGAIN, then awaits Reactor::readable().
+struct FdWatch {
+    int fd = -1;
+    std::coroutine_handle<> waiter;
+    bool ready = false; // an edge arrived while nobody waited
+};
+
+// Single-threaded epoll loop that resumes coroutines when their descriptor
+// becomes readable, so one thread serves any number of devices. Calls that
+// cannot be polled (sysfs attributes block in the driver's SPI transfer)
+// go to one worker thread with offload(), and their coroutine is resumed
+// back on the reactor thread.
+class Reactor {
+public:
+    Reactor() {
+        _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        _eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr; // completions of offloaded calls
+        if (_epollFd < 0 || _eventFd < 0 || ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _eventFd, &event) < 0) {
+            _lastErrno = errno;
+        }
+    }
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    ~Reactor() {
+        if (_worker.joinable()) {
+            {
+                std::lock_guard lock(_mutex);
+                _stopping = true;
+            }
+            _wake.notify_one();
+            _worker.join();
+        }
+        if (_eventFd >= 0) {
+            ::close(_eventFd);
+        }
+        if (_epollFd >= 0) {
+            ::close(_epollFd);
+        }
+    }
+
+    // 0 if the epoll and eventfd descriptors were created.
+    int getLastErrno() const {
+        return _lastErrno;
+    }
+
+    // Same convention as ADS114S0XB::initialize(): {errno, failing call}.
+    std::pair<int, std::string> add(FdWatch &watch) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = &watch;
+        if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, watch.fd, &event) < 0) {
+            return {errno, "epoll_ctl"};
+        }
+        return {0, ""};
+    }
+
+    void remove(FdWatch &watch) {
+        ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, watch.fd, nullptr);
+        watch.waiter = nullptr;
+        watch.ready = false;
+    }
+
+    // Suspends until watch.fd has become readable since the last wait.
+    auto readable(FdWatch &watch) {
+        struct Awaiter {
+            FdWatch &watch;
+            bool await_ready() noexcept {
+                return std::exchange(watch.ready, false);
+            }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                watch.waiter = handle;
+            }
+            void await_resume() noexcept {
+            }
+        };
+        return Awaiter{watch};
+    }
+
+    // Runs call() on the worker thread; the awaiting coroutine resumes on
+    // the reactor thread with its result. Calls run one at a time, in order.
+    template <typename F>
+    auto offload(F call) {
+        using R = decltype(call());
+        struct Awaiter {
+            Reactor &reactor;
+            F call;
+            std::optional<R> result;
+            bool await_ready() noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                reactor.submit([this, handle] {
+                    result.emplace(call());
+                    return handle;
+                });
+            }
+            R await_resume() {
+                return std::move(*result);
+            }
+        };
+        return Awaiter{*this, std::move(call), std::nullopt};
+    }
+
+    // Starts task; run() returns once every spawned task has finished.
+    void spawn(Task<void> task) {
+        _tasks++;
+        detach(std::move(task), _tasks);
+    }
+
+    // Services events on the calling thread until every spawned task has
+    // finished or stop() is called. Returns 0 or the epoll_wait() errno.
+    int run() {
+        _stopped = false;
+        epoll_event events[64];
+        while (_tasks > 0 && !_stopped) {
+            auto n = ::epoll_wait(_epollFd, events, static_cast<int>(std::size(events)), -1);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            for (int i = 0; i < n; i++) {
+                auto watch = static_cast<FdWatch *>(events[i].data.ptr);
+                if (!watch) {
+                    resumeCompleted();
+                }
+                else if (auto waiter = std::exchange(watch->waiter, nullptr)) {
+                    waiter.resume();
+                }
+                else {
+                    watch->ready = true;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // From the reactor thread, e.g. a task that decides the work is done.
+    void stop() {
+        _stopped = true;
+    }
+
+private:
+    using Job = std::function<std::coroutine_handle<>()>;
+
+    // Owns a spawned task: its frame goes away as soon as the task is done.
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() {
+                return {};
+            }
+            std::suspend_never initial_suspend() noexcept {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+            void return_void() {
+            }
+            void unhandled_exception() {
+                std::terminate();
+            }
+        };
+    };
+
+    int _epollFd = -1;
+    int _eventFd = -1;
+    int _lastErrno = 0;
+    size_t _tasks = 0;
+    bool _stopped = false;
+
+    std::thread _worker;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<Job> _jobs;
+    std::vector<std::coroutine_handle<>> _completed;
+    bool _stopping = false;
+
+    static Detached detach(Task<void> task, size_t &tasks) {
+        co_await std::move(task);
+        tasks--;
+    }
+
+    void submit(Job job) {
+        {
+            std::lock_guard lock(_mutex);
+            _jobs.push_back(std::move(job));
+            if (!_worker.joinable()) {
+                _worker = std::thread([this] { workerLoop(); });
+            }
+        }
+        _wake.notify_one();
+    }
+
+    void workerLoop() {
+        std::unique_lock lock(_mutex);
+        for (;;) {
+            _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_stopping) {
+                return;
+            }
+            auto job = std::move(_jobs.front());
+            _jobs.pop_front();
+            lock.unlock();
+            auto handle = job();
+            lock.lock();
+            _completed.push_back(handle);
+            uint64_t one = 1;
+            [[maybe_unused]] auto ret = ::write(_eventFd, &one, sizeof one);
+        }
+    }
+
+    void resumeCompleted() {
+        uint64_t count;
+        [[maybe_unused]] auto ret = ::read(_eventFd, &count, sizeof count);
+        std::vector<std::coroutine_handle<>> completed;
+        {
+            std::lock_guard lock(_mutex);
+            completed.swap(_completed);
+        }
+        for (auto handle : completed) {
+            handle.resume();
+        }
+    }
+};
+
+} // namespace adcs
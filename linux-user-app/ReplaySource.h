@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CaptureFile.h"
+#include "SampleSource.h"
+
+namespace adcs
+{
+// Plays a capture file back as a SampleSource, so recorded data goes
+// through the same AcquisitionEngine and consumers as the live device.
+// Scans keep their recorded timestamps and come either at the recorded
+// pace, N times faster, or as fast as the reader asks (speed 0).
+//
+// Blocks carry the union of every channel set in the file, in ascending
+// channel order like an IIO scan; columns of channels the config in force
+// did not record read as 0. A read never spans a config change, and the
+// config callback runs on the reading thread before the first block under
+// each config, including the first one and after seek().
+//
+// Configure before the first read; the source is not safe to reconfigure
+// while an engine reads it.
+class ReplaySource : public SampleSource {
+public:
+    using ConfigCallback = std::function<void(const CaptureConfig &config, int64_t firstTimestamp)>;
+
+    std::pair<int, std::string> open(const std::string &path) {
+        if (auto status = _reader.open(path); status.first != 0) {
+            return status;
+        }
+        _channelIds.clear();
+        for (const auto &config : _reader.configs()) {
+            for (auto channel : config.channels()) {
+                if (std::find(_channelIds.begin(), _channelIds.end(), channel) == _channelIds.end()) {
+                    _channelIds.push_back(channel);
+                }
+            }
+        }
+        std::sort(_channelIds.begin(), _channelIds.end());
+        _channelIds.resize(std::min(_channelIds.size(), MAX_SCAN_CHANNELS));
+
+        // Block column -> chunk column, per config
+        _columnMaps.clear();
+        for (const auto &config : _reader.configs()) {
+            std::array<int, MAX_SCAN_CHANNELS> map;
+            map.fill(-1);
+            auto channels = config.channels();
+            for (size_t c = 0; c < _channelIds.size(); c++) {
+                auto it = std::find(channels.begin(), channels.end(), _channelIds[c]);
+                if (it != channels.end()) {
+                    map[c] = static_cast<int>(it - channels.begin());
+                }
+            }
+            _columnMaps.push_back(map);
+        }
+
+        // A loop restarts one scan period after the last scan
+        _loopSpan = 0;
+        auto scans = _reader.scanCount();
+        if (scans > 1) {
+            auto first = _reader.chunk(0).firstTimestamp;
+            auto span = _reader.chunk(_reader.chunkCount() - 1).lastTimestamp - first;
+            _loopSpan = span + span / static_cast<int64_t>(scans - 1);
+        }
+        _loopOffset = 0;
+        _scansReplayed = 0;
+        _paceFrom.reset();
+        rewind(0, 0);
+        return {0, ""};
+    }
+
+    // 1 replays at the recorded timing, N at N times that, 0 as fast as
+    // the reader asks.
+    void setSpeed(double speed) {
+        _speed = std::max(speed, 0.0);
+        _paceFrom.reset();
+    }
+
+    // Starts over at the beginning instead of ending the stream. Each pass
+    // shifts the timestamps by the length of the capture, so they keep
+    // increasing.
+    void setLoop(bool loop) {
+        _loop = loop;
+    }
+
+    void setConfigCallback(ConfigCallback callback) {
+        _onConfig = std::move(callback);
+    }
+
+    // Positions the next read at the first scan at or after timestamp (as
+    // recorded). Returns false if there is none.
+    bool seek(int64_t timestamp) {
+        _paceFrom.reset();
+        auto chunk = _reader.seek(timestamp);
+        if (chunk == _reader.chunkCount()) {
+            rewind(chunk, 0);
+            return false;
+        }
+        rewind(chunk, _reader.chunk(chunk).lowerBound(timestamp));
+        return true;
+    }
+
+    // Config in force at a replayed timestamp; safe to call from the
+    // consumer while the engine reads.
+    const CaptureConfig &configAt(int64_t timestamp) const {
+        if (_loopSpan > 0 && _reader.chunkCount() > 0) {
+            auto first = _reader.chunk(0).firstTimestamp;
+            if (timestamp >= first + _loopSpan) {
+                timestamp = first + (timestamp - first) % _loopSpan;
+            }
+        }
+        if (_reader.chunkCount() == 0) {
+            return _reader.configs()[0];
+        }
+        // Between two chunks, the earlier one's config is still in force
+        auto chunk = std::min(_reader.seek(timestamp), _reader.chunkCount() - 1);
+        if (chunk > 0 && _reader.chunk(chunk).firstTimestamp > timestamp) {
+            chunk--;
+        }
+        return _reader.configs()[_reader.chunk(chunk).config];
+    }
+
+    const std::vector<int> &channelIds() const {
+        return _channelIds;
+    }
+
+    const CaptureReader &reader() const {
+        return _reader;
+    }
+
+    uint64_t getScansReplayed() const {
+        return _scansReplayed;
+    }
+
+    void prepare(SampleBlock &block, size_t capacity) override {
+        block.reset(_channelIds, capacity);
+    }
+
+    ssize_t read(SampleBlock &block) override {
+        if (!_reader.isOpen()) {
+            errno = EBADF;
+            return -1;
+        }
+        block.size = 0;
+        if (_chunk == _reader.chunkCount()) {
+            if (!_loop || _loopSpan == 0) {
+                return 0;
+            }
+            _loopOffset += _loopSpan;
+            rewind(0, 0);
+        }
+        auto config = _reader.chunk(_chunk).config;
+        if (config != _config) {
+            _config = config;
+            if (_onConfig) {
+                _onConfig(_reader.configs()[config], _reader.chunk(_chunk).timestamps()[_scan] + _loopOffset);
+            }
+        }
+
+        size_t scans = 0;
+        while (scans < block.capacity() && _chunk < _reader.chunkCount()) {
+            auto chunk = _reader.chunk(_chunk);
+            if (chunk.config != _config) {
+                break;
+            }
+            auto count = std::min(block.capacity() - scans, chunk.scans - _scan);
+            auto timestamps = chunk.timestamps().subspan(_scan, count);
+            for (size_t i = 0; i < count; i++) {
+                block.timestamps[scans + i] = timestamps[i] + _loopOffset;
+            }
+            const auto &map = _columnMaps[_config];
+            for (size_t c = 0; c < block.channelCount(); c++) {
+                auto out = block.channels[c].data() + scans;
+                if (map[c] >= 0) {
+                    std::memcpy(out, chunk.column(static_cast<size_t>(map[c])).data() + _scan, count * sizeof(int16_t));
+                }
+                else {
+                    std::fill_n(out, count, int16_t{0});
+                }
+            }
+            scans += count;
+            _scan += count;
+            if (_scan == chunk.scans) {
+                nextChunk();
+            }
+        }
+        block.size = scans;
+        _scansReplayed += scans;
+
+        // Hand the block over when its last scan was recorded, relative
+        // to the first scan replayed
+        if (_speed > 0 && scans > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (!_paceFrom) {
+                _paceFrom = {now, block.timestamps[0]};
+            }
+            auto recorded = std::chrono::nanoseconds(block.timestamps[scans - 1] - _paceFrom->second);
+            std::this_thread::sleep_until(_paceFrom->first +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(recorded / _speed));
+        }
+        return static_cast<ssize_t>(scans);
+    }
+
+private:
+    static constexpr size_t NO_CONFIG = ~size_t{0};
+
+    CaptureReader _reader;
+    std::vector<int> _channelIds;
+    std::vector<std::array<int, MAX_SCAN_CHANNELS>> _columnMaps;
+    ConfigCallback _onConfig;
+    double _speed = 1.0;
+    bool _loop = false;
+    int64_t _loopSpan = 0;
+    int64_t _loopOffset = 0;
+    size_t _chunk = 0;
+    size_t _scan = 0;
+    size_t _config = NO_CONFIG;
+    uint64_t _scansReplayed = 0;
+    // Wall clock and replayed timestamp that pacing counts from
+    std::optional<std::pair<std::chrono::steady_clock::time_point, int64_t>> _paceFrom;
+
+    void rewind(size_t chunk, size_t scan) {
+        _chunk = chunk;
+        _scan = scan;
+        _config = NO_CONFIG;
+        if (_chunk < _reader.chunkCount() && _scan == _reader.chunk(_chunk).scans) {
+            nextChunk();
+        }
+    }
+
+    // Skips empty chunks as well.
+    void nextChunk() {
+        _scan = 0;
+        do {
+            _chunk++;
+        } while (_chunk < _reader.chunkCount() && _reader.chunk(_chunk).scans == 0);
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace adcs
+{
+// Struct-of-arrays batch of decoded scans: one int16 column per enabled
+// channel plus the timestamp column. Storage is sized once by reset() and
+// reused, so filling a block never allocates.
+struct SampleBlock {
+    std::vector<int> channelIds;
+    std::vector<std::vector<int16_t>> channels;
+    std::vector<int64_t> timestamps;
+    size_t size = 0;
+
+    void reset(const std::vector<int> &ids, size_t capacity) {
+        channelIds = ids;
+        channels.resize(ids.size());
+        for (auto &column : channels) {
+            column.resize(capacity);
+        }
+        timestamps.resize(capacity);
+        size = 0;
+    }
+
+    size_t capacity() const {
+        return timestamps.size();
+    }
+
+    size_t channelCount() const {
+        return channels.size();
+    }
+
+    // Column position of an IIO channel index, -1 if not in the scan.
+    int columnOf(int channelId) const {
+        for (size_t i = 0; i < channelIds.size(); i++) {
+            if (channelIds[i] == channelId) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    std::span<int16_t> column(size_t i) {
+        return {channels[i].data(), size};
+    }
+
+    std::span<const int16_t> column(size_t i) const {
+        return {channels[i].data(), size};
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace adcs
+{
+namespace detail
+{
+using v4su = uint32_t __attribute__((vector_size(16)));
+using v4si = int32_t __attribute__((vector_size(16)));
+using v4hi = int16_t __attribute__((vector_size(8)));
+
+inline v4su loadWord(const uint8_t *in, size_t word) {
+    v4su v;
+    std::memcpy(&v, in + word * sizeof v, sizeof v);
+    return v;
+}
+
+inline void storeWord(uint8_t *out, size_t word, v4su v) {
+    std::memcpy(out + word * sizeof v, &v, sizeof v);
+}
+
+// Inclusive prefix sum across the four lanes.
+inline v4si prefixSum(v4si x) {
+    x += __builtin_shuffle(x, v4si{}, v4si{4, 0, 1, 2});
+    x += __builtin_shuffle(x, v4si{}, v4si{4, 5, 0, 1});
+    return x;
+}
+
+inline v4si broadcastLast(v4si x) {
+    return __builtin_shuffle(x, v4si{3, 3, 3, 3});
+}
+
+// Vertical bit-packing over 4 x 32-bit lanes (as in SIMD-BP128): vector k
+// holds values 4k..4k+3, and every lane packs its 64 values into 2 * width
+// words of its own, so packing and unpacking are plain vector shifts.
+inline void packBlock(const v4su *values, unsigned width, uint8_t *out) {
+    v4su acc{};
+    unsigned bits = 0;
+    size_t word = 0;
+    for (size_t k = 0; k < 64; k++) {
+        acc |= values[k] << bits;
+        bits += width;
+        if (bits >= 32) {
+            storeWord(out, word++, acc);
+            bits -= 32;
+            acc = bits ? values[k] >> (width - bits) : v4su{};
+        }
+    }
+}
+
+// Fully unrolled for each width, so every shift is a constant.
+template <unsigned Width>
+void unpackBlock(const uint8_t *in, v4su *values) {
+    if constexpr (Width == 0) {
+        for (size_t k = 0; k < 64; k++) {
+            values[k] = v4su{};
+        }
+    }
+    else {
+        constexpr uint32_t mask = (1u << Width) - 1;
+        v4su word = loadWord(in, 0);
+        size_t next = 1;
+        unsigned bits = 0;
+#pragma GCC unroll 64
+        for (size_t k = 0; k < 64; k++) {
+            v4su v = word >> bits;
+            if (bits + Width > 32) {
+                word = loadWord(in, next++);
+                v |= word << (32 - bits);
+                bits = bits + Width - 32;
+            }
+            else if (bits + Width == 32) {
+                bits = 0;
+                if (next < 2 * Width) {
+                    word = loadWord(in, next++);
+                }
+            }
+            else {
+                bits += Width;
+            }
+            values[k] = v & mask;
+        }
+    }
+}
+} // namespace detail
+
+// Lossless codec for int16 sample columns. Samples are cut into blocks of
+// BLOCK_SAMPLES, each decodable on its own. Per block the encoder picks
+// whichever predictor gives the narrowest residuals: none, delta, or
+// delta of delta (second order). Residuals are zigzag-coded (the raw codes
+// of order 0 are offset to unsigned instead, so noise never costs more
+// than 16 bits), reduced by their minimum (frame of reference) and
+// bit-packed at a fixed width.
+//
+// Block layout, little-endian:
+//   uint8  order | width << 2
+//   uint8  samples - 1
+//   int16  first sample
+//   uint32 frame of reference
+//   32 * width bytes of packed residuals
+class SampleCodec {
+public:
+    static constexpr size_t BLOCK_SAMPLES = 256;
+    static constexpr size_t HEADER_BYTES = 8;
+    static constexpr unsigned MAX_WIDTH = 18; // second-order residuals of full-scale steps
+    static constexpr unsigned MAX_ORDER = 2;
+
+    static constexpr size_t maxEncodedSize(size_t samples) {
+        return (samples + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES * blockBytes(MAX_WIDTH);
+    }
+
+    static constexpr size_t blockBytes(unsigned width) {
+        return HEADER_BYTES + BLOCK_SAMPLES / 8 * width;
+    }
+
+    // Returns the encoded size, or nullopt if out is smaller than
+    // maxEncodedSize(in.size()).
+    static std::optional<size_t> encode(std::span<const int16_t> in, std::span<uint8_t> out) {
+        if (out.size() < maxEncodedSize(in.size())) {
+            return std::nullopt;
+        }
+        size_t bytes = 0;
+        for (size_t i = 0; i < in.size(); i += BLOCK_SAMPLES) {
+            bytes += encodeBlock(in.subspan(i, std::min(BLOCK_SAMPLES, in.size() - i)), out.data() + bytes);
+        }
+        return bytes;
+    }
+
+    // Decodes a whole stream. Returns the number of samples, or nullopt
+    // if the stream is damaged or out is too small.
+    static std::optional<size_t> decode(std::span<const uint8_t> in, std::span<int16_t> out) {
+        size_t samples = 0;
+        int16_t tail[BLOCK_SAMPLES];
+        while (!in.empty()) {
+            auto header = readHeader(in);
+            if (!header || out.size() - samples < header->samples) {
+                return std::nullopt;
+            }
+            // Full blocks decode in place, a short one through tail[]
+            bool direct = out.size() - samples >= BLOCK_SAMPLES;
+            decodeBlock(*header, in.data(), direct ? out.data() + samples : tail);
+            if (!direct) {
+                std::memcpy(out.data() + samples, tail, header->samples * sizeof(int16_t));
+            }
+            samples += header->samples;
+            in = in.subspan(header->bytes);
+        }
+        return samples;
+    }
+
+    // Start of every block, for random access: block k holds samples
+    // k * BLOCK_SAMPLES onwards. nullopt if the stream is damaged.
+    static std::optional<std::vector<size_t>> blockOffsets(std::span<const uint8_t> in) {
+        std::vector<size_t> offsets;
+        size_t offset = 0;
+        while (offset < in.size()) {
+            auto header = readHeader(in.subspan(offset));
+            if (!header) {
+                return std::nullopt;
+            }
+            offsets.push_back(offset);
+            offset += header->bytes;
+        }
+        return offsets;
+    }
+
+    // Decodes the block at the start of in into out, which must hold
+    // BLOCK_SAMPLES. Returns the number of samples.
+    static std::optional<size_t> decodeBlock(std::span<const uint8_t> in, int16_t *out) {
+        auto header = readHeader(in);
+        if (!header) {
+            return std::nullopt;
+        }
+        decodeBlock(*header, in.data(), out);
+        return header->samples;
+    }
+
+private:
+    using v4su = detail::v4su;
+    using v4si = detail::v4si;
+
+    struct Header {
+        unsigned order;
+        unsigned width;
+        size_t samples;
+        int16_t first;
+        uint32_t reference;
+        size_t bytes;
+    };
+
+    static std::optional<Header> readHeader(std::span<const uint8_t> in) {
+        if (in.size() < HEADER_BYTES) {
+            return std::nullopt;
+        }
+        Header header;
+        header.order = in[0] & 3;
+        header.width = in[0] >> 2;
+        header.samples = static_cast<size_t>(in[1]) + 1;
+        std::memcpy(&header.first, &in[2], sizeof header.first);
+        std::memcpy(&header.reference, &in[4], sizeof header.reference);
+        header.bytes = blockBytes(header.width);
+        if (header.order > MAX_ORDER || header.width > MAX_WIDTH || in.size() < header.bytes) {
+            return std::nullopt;
+        }
+        return header;
+    }
+
+    static unsigned bitWidth(uint32_t value) {
+        return value ? 32 - static_cast<unsigned>(__builtin_clz(value)) : 0;
+    }
+
+    static uint32_t zigzag(int32_t value) {
+        return static_cast<uint32_t>(value) << 1 ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static size_t encodeBlock(std::span<const int16_t> in, uint8_t *out) {
+        // Pad a short block with its last sample, which costs the
+        // predictors nothing
+        int32_t x[BLOCK_SAMPLES];
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            x[i] = in[std::min(i, in.size() - 1)];
+        }
+
+        uint32_t residuals[MAX_ORDER + 1][BLOCK_SAMPLES];
+        int32_t previousDelta = 0;
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            int32_t delta = i ? x[i] - x[i - 1] : 0;
+            residuals[0][i] = static_cast<uint32_t>(x[i] + 32768);
+            residuals[1][i] = zigzag(delta);
+            residuals[2][i] = zigzag(delta - previousDelta);
+            previousDelta = delta;
+        }
+
+        unsigned order = 0;
+        unsigned width = 32;
+        uint32_t reference = 0;
+        for (unsigned o = 0; o <= MAX_ORDER; o++) {
+            uint32_t low = UINT32_MAX;
+            uint32_t high = 0;
+            for (auto r : residuals[o]) {
+                low = std::min(low, r);
+                high = std::max(high, r);
+            }
+            if (bitWidth(high - low) < width) {
+                order = o;
+                width = bitWidth(high - low);
+                reference = low;
+            }
+        }
+
+        v4su values[BLOCK_SAMPLES / 4];
+        for (size_t k = 0; k < BLOCK_SAMPLES / 4; k++) {
+            for (size_t lane = 0; lane < 4; lane++) {
+                values[k][lane] = residuals[order][4 * k + lane] - reference;
+            }
+        }
+        out[0] = static_cast<uint8_t>(order | width << 2);
+        out[1] = static_cast<uint8_t>(in.size() - 1);
+        int16_t first = in[0];
+        std::memcpy(&out[2], &first, sizeof first);
+        std::memcpy(&out[4], &reference, sizeof reference);
+        if (width > 0) {
+            detail::packBlock(values, width, out + HEADER_BYTES);
+        }
+        return blockBytes(width);
+    }
+
+    template <size_t... Widths>
+    static constexpr auto makeUnpackers(std::index_sequence<Widths...>) {
+        return std::array<void (*)(const uint8_t *, v4su *), sizeof...(Widths)>{
+            &detail::unpackBlock<Widths>...};
+    }
+
+    // Always writes BLOCK_SAMPLES samples.
+    static void decodeBlock(const Header &header, const uint8_t *in, int16_t *out) {
+        static constexpr auto unpackers = makeUnpackers(std::make_index_sequence<MAX_WIDTH + 1>());
+        v4su values[BLOCK_SAMPLES / 4];
+        unpackers[header.width](in + HEADER_BYTES, values);
+        switch (header.order) {
+        case 0:
+            reconstruct<0>(values, header, out);
+            break;
+        case 1:
+            reconstruct<1>(values, header, out);
+            break;
+        default:
+            reconstruct<2>(values, header, out);
+            break;
+        }
+    }
+
+    // Undoes the frame of reference, zigzag and Order prefix sums, four
+    // samples per step.
+    template <unsigned Order>
+    static void reconstruct(const v4su *values, const Header &header, int16_t *out) {
+        v4si x = v4si{} + header.first;
+        v4si delta{};
+        for (size_t k = 0; k < BLOCK_SAMPLES / 4; k++) {
+            v4su z = values[k] + header.reference;
+            if constexpr (Order == 0) {
+                x = reinterpret_cast<v4si>(z) - 32768;
+            }
+            else {
+                auto r = reinterpret_cast<v4si>(z >> 1) ^ -reinterpret_cast<v4si>(z & 1);
+                if constexpr (Order == 2) {
+                    delta = detail::prefixSum(r) + detail::broadcastLast(delta);
+                    r = delta;
+                }
+                x = detail::prefixSum(r) + detail::broadcastLast(x);
+            }
+            auto samples = __builtin_convertvector(x, detail::v4hi);
+            std::memcpy(out + 4 * k, &samples, sizeof samples);
+        }
+    }
+};
+
+} // namespace adcs
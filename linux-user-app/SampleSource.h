@@ -0,0 +1,33 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+
+#include "SampleBlock.h"
+
+namespace adcs
+{
+class Metrics;
+
+// Anything that produces decoded scans: the character device, a libiio
+// buffer, or a stand-in. Sources are configured and started by their
+// owner; consumers such as AcquisitionEngine only size blocks and read.
+class SampleSource {
+public:
+    virtual ~SampleSource() = default;
+
+    // Sizes block (channel columns and capacity) for this source.
+    virtual void prepare(SampleBlock &block, size_t capacity) = 0;
+
+    // Blocks until scans are available and fills block. Returns the number
+    // of scans, 0 at end of stream, or a negative value on error.
+    virtual ssize_t read(SampleBlock &block) = 0;
+
+    // Sources that talk to a device record their read and decode stages
+    // into metrics; the default ignores it.
+    virtual void setMetrics(Metrics *) {
+    }
+};
+
+} // namespace adcs
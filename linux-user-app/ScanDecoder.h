@@ -0,0 +1,274 @@
+#pragma once
+
+#include <endian.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SampleBlock.h"
+
+namespace adcs
+{
+// One entry of scan_elements/: format parsed from <name>_type, position
+// from <name>_index. channelId is the N of in_voltageN, -1 for timestamp.
+struct ScanElement {
+    std::string name;
+    int index = 0;
+    int channelId = -1;
+    bool isTimestamp = false;
+    bool isSigned = true;
+    bool isBigEndian = false;
+    unsigned realBits = 16;
+    unsigned storageBits = 16;
+    unsigned shift = 0;
+    unsigned repeat = 1;
+    size_t offset = 0; // byte offset inside a record, set by ScanLayout
+
+    size_t storageBytes() const {
+        return storageBits / 8;
+    }
+};
+
+// Record layout of /dev/iio:deviceN for the enabled scan elements, laid out
+// the way the IIO core does it: elements in index order, each aligned to
+// its own size, the record padded to the largest element.
+class ScanLayout {
+public:
+    ScanLayout() = default;
+
+    explicit ScanLayout(std::vector<ScanElement> enabledElements) :
+        _elements(std::move(enabledElements)) {
+        computeOffsets();
+    }
+
+    // Parses "[be|le]:[s|u]bits/storagebits[Xrepeat]>>shift"
+    static std::optional<ScanElement> parseType(const std::string &type) {
+        ScanElement element;
+        char endianness, sign;
+        unsigned realBits, storageBits, repeat = 1, shift;
+        if (sscanf(type.c_str(), "%ce:%c%u/%uX%u>>%u",
+                &endianness, &sign, &realBits, &storageBits, &repeat, &shift) != 6) {
+            repeat = 1;
+            if (sscanf(type.c_str(), "%ce:%c%u/%u>>%u",
+                    &endianness, &sign, &realBits, &storageBits, &shift) != 5) {
+                return std::nullopt;
+            }
+        }
+        if ((endianness != 'b' && endianness != 'l') ||
+            (sign != 's' && sign != 'u') ||
+            (storageBits != 8 && storageBits != 16 &&
+             storageBits != 32 && storageBits != 64) ||
+            realBits == 0 || realBits > storageBits || repeat == 0) {
+            return std::nullopt;
+        }
+        element.isBigEndian = endianness == 'b';
+        element.isSigned = sign == 's';
+        element.realBits = realBits;
+        element.storageBits = storageBits;
+        element.repeat = repeat;
+        element.shift = shift;
+        return element;
+    }
+
+    // Reads every enabled element from scan_elements/ once, normally right
+    // before the buffer is enabled.
+    static std::optional<ScanLayout> fromScanElementsDir(const std::string &dir) {
+        namespace fs = std::filesystem;
+        static const std::string EN_SUFFIX{"_en"};
+        std::vector<ScanElement> enabled;
+        std::error_code ec;
+
+        for (const auto &entry : fs::directory_iterator(dir, ec)) {
+            auto file = entry.path().filename().string();
+            if (file.size() <= EN_SUFFIX.size() ||
+                file.compare(file.size() - EN_SUFFIX.size(), EN_SUFFIX.size(), EN_SUFFIX) != 0) {
+                continue;
+            }
+            auto name = file.substr(0, file.size() - EN_SUFFIX.size());
+            auto en = readAttribute(dir + file);
+            if (!en || std::stoi(*en) == 0) {
+                continue;
+            }
+            auto type = readAttribute(dir + name + "_type");
+            auto index = readAttribute(dir + name + "_index");
+            if (!type || !index) {
+                return std::nullopt;
+            }
+            auto element = parseType(*type);
+            if (!element) {
+                return std::nullopt;
+            }
+            element->name = name;
+            element->index = std::stoi(*index);
+            element->isTimestamp = name.find("timestamp") != std::string::npos;
+            element->channelId = element->isTimestamp ? -1 : trailingNumber(name);
+            enabled.push_back(*element);
+        }
+        if (ec) {
+            return std::nullopt;
+        }
+        return ScanLayout(std::move(enabled));
+    }
+
+    const std::vector<ScanElement> &elements() const {
+        return _elements;
+    }
+
+    size_t recordSize() const {
+        return _recordSize;
+    }
+
+    std::vector<int> channelIds() const {
+        std::vector<int> ids;
+        for (const auto &element : _elements) {
+            if (!element.isTimestamp) {
+                ids.push_back(element.channelId);
+            }
+        }
+        return ids;
+    }
+
+    bool hasTimestamp() const {
+        return std::any_of(_elements.begin(), _elements.end(),
+            [](const ScanElement &e) { return e.isTimestamp; });
+    }
+
+private:
+    std::vector<ScanElement> _elements;
+    size_t _recordSize = 0;
+
+    void computeOffsets() {
+        std::sort(_elements.begin(), _elements.end(),
+            [](const ScanElement &a, const ScanElement &b) { return a.index < b.index; });
+        size_t bytes = 0, largest = 0;
+        for (auto &element : _elements) {
+            size_t length = element.storageBytes() * element.repeat;
+            bytes = alignUp(bytes, length);
+            element.offset = bytes;
+            bytes += length;
+            largest = std::max(largest, length);
+        }
+        _recordSize = largest ? alignUp(bytes, largest) : 0;
+    }
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static int trailingNumber(const std::string &name) {
+        auto pos = name.find_last_not_of("0123456789");
+        if (pos == std::string::npos || pos + 1 == name.size()) {
+            return -1;
+        }
+        return std::stoi(name.substr(pos + 1));
+    }
+
+    static std::optional<std::string> readAttribute(const std::string &path) {
+        std::ifstream file(path);
+        std::string value;
+        if (!file || !std::getline(file, value)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+};
+
+// Decodes whole batches of raw records into a SampleBlock. The per-element
+// conversion parameters are fixed at construction, decode() only walks memory.
+class ScanDecoder {
+public:
+    ScanDecoder() = default;
+
+    explicit ScanDecoder(const ScanLayout &layout) :
+        _layout(layout) {
+        for (const auto &element : _layout.elements()) {
+            if (element.isTimestamp) {
+                _timestamp = element;
+            } else {
+                _columns.push_back(element);
+            }
+        }
+    }
+
+    const ScanLayout &layout() const {
+        return _layout;
+    }
+
+    size_t recordSize() const {
+        return _layout.recordSize();
+    }
+
+    void prepare(SampleBlock &block, size_t capacity) const {
+        block.reset(_layout.channelIds(), capacity);
+    }
+
+    // Decodes as many complete records as fit in both raw and block.
+    // Returns the number of records, which also becomes block.size.
+    size_t decode(std::span<const uint8_t> raw, SampleBlock &block) const {
+        if (_layout.recordSize() == 0) {
+            block.size = 0;
+            return 0;
+        }
+        size_t records = std::min(raw.size() / _layout.recordSize(), block.capacity());
+        const uint8_t *record = raw.data();
+
+        for (size_t r = 0; r < records; r++, record += _layout.recordSize()) {
+            for (size_t c = 0; c < _columns.size(); c++) {
+                block.channels[c][r] = static_cast<int16_t>(extract(_columns[c], record));
+            }
+            block.timestamps[r] = _timestamp ? extract(*_timestamp, record) : 0;
+        }
+        block.size = records;
+        return records;
+    }
+
+private:
+    ScanLayout _layout;
+    std::vector<ScanElement> _columns;
+    std::optional<ScanElement> _timestamp;
+
+    static int64_t extract(const ScanElement &element, const uint8_t *record) {
+        const uint8_t *src = record + element.offset;
+        uint64_t value;
+        switch (element.storageBits) {
+        case 8:
+            value = *src;
+            break;
+        case 16: {
+            uint16_t v;
+            memcpy(&v, src, sizeof v);
+            value = element.isBigEndian ? be16toh(v) : le16toh(v);
+            break;
+        }
+        case 32: {
+            uint32_t v;
+            memcpy(&v, src, sizeof v);
+            value = element.isBigEndian ? be32toh(v) : le32toh(v);
+            break;
+        }
+        default: {
+            uint64_t v;
+            memcpy(&v, src, sizeof v);
+            value = element.isBigEndian ? be64toh(v) : le64toh(v);
+            break;
+        }
+        }
+        value >>= element.shift;
+        if (element.realBits < 64) {
+            value &= (uint64_t{1} << element.realBits) - 1;
+            if (element.isSigned && (value >> (element.realBits - 1)) & 1) {
+                value |= ~uint64_t{0} << element.realBits;
+            }
+        }
+        return static_cast<int64_t>(value);
+    }
+};
+
+} // namespace adcs
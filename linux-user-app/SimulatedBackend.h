@@ -0,0 +1,649 @@
+#pragma once
+
+#include <endian.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "ADS114S0XBRegisters.h"
+#include "AdcBackend.h"
+#include "VoltageConverter.h"
+
+namespace adcs
+{
+// Voltage on one analog input as a function of time.
+struct Waveform {
+    enum class Shape { Dc, Sine, Square, Steps };
+
+    Shape shape = Shape::Dc;
+    double offset = 0.0;        // V
+    double amplitude = 0.0;     // V, peak
+    double frequency = 0.0;     // Hz; Steps: level changes per second
+    std::vector<double> levels; // V, Steps only
+    double noise = 0.0;         // V rms, added to any shape
+
+    static Waveform dc(double volts) {
+        Waveform w;
+        w.offset = volts;
+        return w;
+    }
+
+    static Waveform sine(double amplitude, double frequency, double offset = 0.0) {
+        Waveform w;
+        w.shape = Shape::Sine;
+        w.amplitude = amplitude;
+        w.frequency = frequency;
+        w.offset = offset;
+        return w;
+    }
+
+    static Waveform square(double amplitude, double frequency, double offset = 0.0) {
+        auto w = sine(amplitude, frequency, offset);
+        w.shape = Shape::Square;
+        return w;
+    }
+
+    static Waveform steps(std::vector<double> levels, double stepsPerSecond) {
+        Waveform w;
+        w.shape = Shape::Steps;
+        w.levels = std::move(levels);
+        w.frequency = stepsPerSecond;
+        return w;
+    }
+
+    Waveform withNoise(double rms) const {
+        auto w = *this;
+        w.noise = rms;
+        return w;
+    }
+
+    // Noise-free value at t seconds.
+    double valueAt(double t) const {
+        switch (shape) {
+        case Shape::Sine:
+            return offset + amplitude * std::sin(2 * M_PI * frequency * t);
+        case Shape::Square:
+            return offset + (std::fmod(frequency * t, 1.0) < 0.5 ? amplitude : -amplitude);
+        case Shape::Steps:
+            if (levels.empty()) {
+                return offset;
+            }
+            return offset + levels[static_cast<size_t>(frequency * t) % levels.size()];
+        default:
+            return offset;
+        }
+    }
+};
+
+// In-process ADS114S0XB for machines without the chip or the driver. It
+// keeps its own register file and converts the configured input waveforms
+// the way the chip would: the INPMUX pair is subtracted, PGA gain and the
+// REF selection set the LSB, OFCAL/FSCAL are applied, and anything beyond
+// full scale saturates at 0x7fff/0x8000. Like the driver, a multi-channel
+// scan converts channel N with INPMUX = N, while a single-channel scan
+// keeps whatever INPMUX holds. Channels with a writeCalibrationTable()
+// entry convert with it, the rest of such a scan with OFCAL/FSCAL as they
+// were at enable, and "calibrate" computes OFCAL/FSCAL from the waveforms,
+// taking the CAL_SAMP conversions it would take on the chip.
+//
+// Scans come at the DATARATE setting unless setSampleRate() overrides it,
+// e.g. far beyond the chip's 4 kSPS for load tests, and are either paced
+// in real time or produced as fast as the reader asks (FreeRunning) with
+// simulated timestamps. setDropProbability() loses scans the way a slow
+// reader would, which shows up as timestamp gaps and short reads; a read
+// that lost every scan fails with EAGAIN, which AcquisitionEngine retries.
+class SimulatedBackend : public AdcBackend {
+public:
+    enum class Pacing { RealTime, FreeRunning };
+
+    static constexpr size_t NUM_REGISTERS = 0x12;
+    static constexpr size_t AINCOM = static_cast<size_t>(Inpmux::Positive::AINCOM);
+
+    explicit SimulatedBackend(ChipVariant chip = ChipVariant::ADS114S08B) :
+        _numInputs(chip == ChipVariant::ADS114S06B ?
+            ChipTraits<ChipVariant::ADS114S06B>::numInputs : ChipTraits<ChipVariant::ADS114S08B>::numInputs) {
+        for (auto &reg : REGISTER_DESCRIPTORS) {
+            if (reg.address < NUM_REGISTERS) {
+                _registers[reg.address] = reg.resetValue;
+            }
+        }
+        _registers[describe(ADS114S0XBRegister::ID).address] = chip == ChipVariant::ADS114S06B ? 0x05 : 0x04;
+        _inputs.resize(AINCOM + 1);
+    }
+
+    std::pair<int, std::string> open(const std::string & = "") override {
+        return {0, ""};
+    }
+
+    // input is 0-11 for AINn, 12 for AINCOM.
+    void setInput(size_t input, const Waveform &waveform) {
+        std::lock_guard lock(_mutex);
+        if (input < _inputs.size()) {
+            _inputs[input] = waveform;
+            _generation++;
+        }
+    }
+
+    // 0 follows the DATARATE register.
+    void setSampleRate(double samplesPerSecond) {
+        std::lock_guard lock(_mutex);
+        _rateOverride = samplesPerSecond;
+        _generation++;
+    }
+
+    void setPacing(Pacing pacing) {
+        std::lock_guard lock(_mutex);
+        _pacing = pacing;
+        _generation++;
+    }
+
+    void setDropProbability(double probability) {
+        std::lock_guard lock(_mutex);
+        _dropProbability = std::clamp(probability, 0.0, 1.0);
+        _generation++;
+    }
+
+    // Reference voltage used when REF selects REFP0/REFN0 or REFP1/REFN1.
+    void setExternalVref(double volts) {
+        std::lock_guard lock(_mutex);
+        _externalVref = volts;
+        _generation++;
+    }
+
+    // Sources report end of stream after this many scans; 0 is unlimited.
+    void setScanLimit(uint64_t scans) {
+        std::lock_guard lock(_mutex);
+        _scanLimit = scans;
+        _generation++;
+    }
+
+    uint64_t getDroppedScans() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    std::optional<std::string> readAttribute(const std::string &name) override {
+        auto value = readAttributeValue(name);
+        if (!value) {
+            return std::nullopt;
+        }
+        return std::to_string(*value) + "\n";
+    }
+
+    bool writeAttribute(const std::string &name, const std::string &value) override {
+        if (name == CALIBRATE) {
+            return calibrate(value);
+        }
+        char *end;
+        errno = 0;
+        auto parsed = std::strtoll(value.c_str(), &end, 10);
+        if (errno != 0 || end == value.c_str()) {
+            _last_errno = EINVAL;
+            return false;
+        }
+        return writeAttributeValue(name, parsed);
+    }
+
+    std::optional<long long> readAttributeValue(const std::string &name) override {
+        std::lock_guard lock(_mutex);
+        if (name == describe(ADS114S0XBRegister::SENSOR_MOCK_MODE).name) {
+            return _mockMode ? 1 : 0;
+        }
+        if (name == BUFFER_ENABLE) {
+            return _bufferEnabled ? 1 : 0;
+        }
+        if (auto channel = scanEnableChannel(name); channel >= 0) {
+            return std::find(_channels.begin(), _channels.end(), channel) != _channels.end();
+        }
+        if (auto address = registerAddress(name); address >= 0) {
+            return _registers[address];
+        }
+        _last_errno = ENOENT;
+        return std::nullopt;
+    }
+
+    bool writeAttributeValue(const std::string &name, long long value) override {
+        std::lock_guard lock(_mutex);
+        if (value < 0) {
+            _last_errno = EINVAL;
+            return false;
+        }
+        if (name == describe(ADS114S0XBRegister::SENSOR_MOCK_MODE).name) {
+            _mockMode = value != 0;
+        }
+        else if (name == BUFFER_ENABLE) {
+            // Enabled for real by createSampleSource()
+            if (value == 0) {
+                _bufferEnabled = false;
+            }
+        }
+        else if (auto channel = scanEnableChannel(name); channel >= 0) {
+            if (static_cast<size_t>(channel) >= _numInputs) {
+                _last_errno = ENOENT;
+                return false;
+            }
+            if (_bufferEnabled) {
+                _last_errno = EBUSY;
+                return false;
+            }
+            auto it = std::find(_channels.begin(), _channels.end(), channel);
+            if (value && it == _channels.end()) {
+                _channels.insert(std::upper_bound(_channels.begin(), _channels.end(), channel), channel);
+            }
+            else if (!value && it != _channels.end()) {
+                _channels.erase(it);
+            }
+        }
+        else if (auto address = registerAddress(name); address >= 0) {
+            // The driver rejects a mux value it has no channel for
+            if ((address == describe(ADS114S0XBRegister::INPMUX).address &&
+                    static_cast<size_t>(value) >= _numInputs) || value > 0xff) {
+                _last_errno = EINVAL;
+                return false;
+            }
+            _registers[address] = static_cast<uint8_t>(value);
+        }
+        else {
+            _last_errno = ENOENT;
+            return false;
+        }
+        _generation++;
+        return true;
+    }
+
+    std::optional<size_t> readRegisterBlock(uint8_t first, std::span<uint8_t> values) override {
+        std::lock_guard lock(_mutex);
+        if (first >= NUM_REGISTERS) {
+            return 0;
+        }
+        auto count = std::min(values.size(), NUM_REGISTERS - first);
+        std::copy_n(_registers.begin() + first, count, values.begin());
+        return count;
+    }
+
+    std::optional<size_t> writeRegisterBlock(uint8_t first, std::span<const uint8_t> values) override {
+        std::lock_guard lock(_mutex);
+        if (first >= NUM_REGISTERS) {
+            _last_errno = EFBIG;
+            return std::nullopt;
+        }
+        auto count = std::min(values.size(), NUM_REGISTERS - first);
+        std::copy_n(values.begin(), count, _registers.begin() + first);
+        _generation++;
+        return count;
+    }
+
+    std::optional<size_t> writeCalibrationTable(int firstChannel, std::span<const uint8_t> entries) override {
+        std::lock_guard lock(_mutex);
+        if (firstChannel < 0 || static_cast<size_t>(firstChannel) >= _numInputs) {
+            _last_errno = EFBIG;
+            return std::nullopt;
+        }
+        // Whole entries only, as the driver takes them
+        if (entries.size() % CALIBRATION_ENTRY_SIZE) {
+            _last_errno = EINVAL;
+            return std::nullopt;
+        }
+        auto first = static_cast<size_t>(firstChannel);
+        auto channels = std::min(entries.size() / CALIBRATION_ENTRY_SIZE, _numInputs - first);
+        for (size_t i = 0; i < channels; i++) {
+            auto &entry = _calibration[first + i];
+            std::copy_n(entries.begin() + i * CALIBRATION_ENTRY_SIZE, CALIBRATION_ENTRY_SIZE, entry.begin());
+            entry[RESERVED_0D] = 0;
+            // The reset words remove the entry
+            _calibrationValid[first + i] = entry != CALIBRATION_RESET;
+        }
+        _generation++;
+        return channels * CALIBRATION_ENTRY_SIZE;
+    }
+
+    std::optional<ScanLayout> scanLayout() override {
+        std::lock_guard lock(_mutex);
+        std::vector<ScanElement> elements;
+        for (auto channel : _channels) {
+            ScanElement element;
+            element.name = "in_voltage" + std::to_string(channel);
+            element.index = channel;
+            element.channelId = channel;
+            element.isBigEndian = __BYTE_ORDER == __BIG_ENDIAN;
+            elements.push_back(element);
+        }
+        ScanElement timestamp;
+        timestamp.name = "in_timestamp";
+        timestamp.index = static_cast<int>(_numInputs);
+        timestamp.isTimestamp = true;
+        timestamp.isBigEndian = __BYTE_ORDER == __BIG_ENDIAN;
+        timestamp.realBits = timestamp.storageBits = 64;
+        elements.push_back(timestamp);
+        return ScanLayout(std::move(elements));
+    }
+
+    std::unique_ptr<SampleSource> createSampleSource(const std::vector<int> &channels,
+            size_t samplesPerRead) override {
+        std::lock_guard lock(_mutex);
+        if (_bufferEnabled) {
+            _last_errno = EBUSY;
+            return nullptr;
+        }
+        for (auto channel : channels) {
+            if (channel < 0 || static_cast<size_t>(channel) >= _numInputs) {
+                _last_errno = ENOENT;
+                return nullptr;
+            }
+        }
+        // As the driver: once a channel of the scan has an entry, every
+        // channel converts with its entry or with OFCAL/FSCAL from before
+        // the enable, the first one loaded right away
+        std::copy_n(_registers.begin() + OFCAL0, CALIBRATION_ENTRY_SIZE, _calibrationSaved.begin());
+        _scanCalibrated = std::any_of(channels.begin(), channels.end(),
+            [&](int channel) { return _calibrationValid[channel]; });
+        for (size_t c = 0; c < AINCOM; c++) {
+            _scanCalibration[c] = _calibrationValid[c] ? _calibration[c] : _calibrationSaved;
+        }
+        if (_scanCalibrated) {
+            std::copy_n(_scanCalibration[channels[0]].begin(), CALIBRATION_ENTRY_SIZE, _registers.begin() + OFCAL0);
+        }
+        _bufferEnabled = true;
+        _generation++;
+        return std::make_unique<Source>(*this, channels, samplesPerRead);
+    }
+
+    int getLastErrno() const override {
+        return _last_errno;
+    }
+
+private:
+    static constexpr const char *BUFFER_ENABLE = "buffer/enable";
+    static constexpr const char *CALIBRATE = "calibrate";
+    static constexpr size_t OFCAL0 = describe(ADS114S0XBRegister::OFCAL0).address;
+    static constexpr size_t RESERVED_0D = 2; // within a calibration entry
+    static constexpr unsigned CALIBRATION_SAMPLES[] = {1, 4, 8, 16};
+    using CalibrationEntry = std::array<uint8_t, CALIBRATION_ENTRY_SIZE>;
+    static constexpr CalibrationEntry CALIBRATION_RESET = {0x00, 0x00, 0x00, 0x00, 0x40};
+    static constexpr double DATA_RATES_SPS[] = {
+        2.5, 5, 10, 16.6, 20, 50, 60, 100, 200, 400, 800, 1000, 2000, 4000, 4000, 4000,
+    };
+
+    // Snapshot of everything a conversion depends on, refreshed by the
+    // source only when the backend's generation moves.
+    struct Config {
+        uint64_t generation = ~0ull;
+        std::array<uint8_t, NUM_REGISTERS> registers{};
+        std::vector<Waveform> inputs;
+        std::array<CalibrationEntry, AINCOM> scanCalibration{};
+        bool scanCalibrated = false;
+        bool mockMode = false;
+        bool bufferEnabled = false;
+        double rate = 20.0;
+        double externalVref = 2.5;
+        double dropProbability = 0.0;
+        uint64_t scanLimit = 0;
+        Pacing pacing = Pacing::RealTime;
+    };
+
+    class Source : public SampleSource {
+    public:
+        Source(SimulatedBackend &backend, std::vector<int> channels, size_t samplesPerRead) :
+            _backend(backend),
+            _channels(std::move(channels)),
+            _samplesPerRead(std::max<size_t>(samplesPerRead, 1)),
+            _epoch(std::chrono::steady_clock::now()),
+            _epochNs(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()) {
+        }
+
+        ~Source() override {
+            std::lock_guard lock(_backend._mutex);
+            // The driver restores OFCAL/FSCAL on disable
+            std::copy_n(_backend._calibrationSaved.begin(), CALIBRATION_ENTRY_SIZE,
+                _backend._registers.begin() + OFCAL0);
+            _backend._bufferEnabled = false;
+            _backend._generation++;
+        }
+
+        void prepare(SampleBlock &block, size_t capacity) override {
+            block.reset(_channels, capacity);
+        }
+
+        ssize_t read(SampleBlock &block) override {
+            refresh();
+            if (!_config.bufferEnabled) {
+                errno = EBUSY;
+                return -1;
+            }
+            auto limit = std::min(_samplesPerRead, block.capacity());
+            if (_config.scanLimit) {
+                limit = std::min<uint64_t>(limit, _config.scanLimit - std::min(_emitted, _config.scanLimit));
+                if (limit == 0) {
+                    block.size = 0;
+                    return 0;
+                }
+            }
+
+            // Dropped scans count against the read, so it ends even when
+            // every scan is lost
+            size_t scans = 0;
+            double t = 0.0;
+            for (size_t generated = 0; generated < limit; generated++) {
+                t = static_cast<double>(_scanIndex++) / _config.rate;
+                if (_config.dropProbability > 0 && _uniform(_rng) < _config.dropProbability) {
+                    _backend._dropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                for (size_t c = 0; c < _channels.size(); c++) {
+                    block.channels[c][scans] = convert(_channels[c], t);
+                }
+                block.timestamps[scans] = _epochNs + static_cast<int64_t>(t * 1e9);
+                scans++;
+            }
+            _emitted += scans;
+            block.size = scans;
+
+            if (_config.pacing == Pacing::RealTime) {
+                std::this_thread::sleep_until(_epoch + std::chrono::duration<double>(t));
+            }
+            if (scans == 0) {
+                errno = EAGAIN; // 0 would be the end of the stream
+                return -1;
+            }
+            return static_cast<ssize_t>(scans);
+        }
+
+    private:
+        SimulatedBackend &_backend;
+        std::vector<int> _channels;
+        size_t _samplesPerRead;
+        std::chrono::steady_clock::time_point _epoch;
+        int64_t _epochNs;
+        Config _config;
+        uint64_t _scanIndex = 0;
+        uint64_t _emitted = 0;
+        uint16_t _mockCounter = 0;
+        double _lsb = 1.0;
+        // Per channel: the words the scan loads for it, or OFCAL/FSCAL
+        std::array<double, AINCOM> _ofcal{};
+        std::array<double, AINCOM> _fscal{};
+        std::minstd_rand _rng{1};
+        std::uniform_real_distribution<double> _uniform{0.0, 1.0};
+        std::normal_distribution<double> _normal{0.0, 1.0};
+
+        void refresh() {
+            if (_backend._generation.load(std::memory_order_acquire) == _config.generation) {
+                return;
+            }
+            std::lock_guard lock(_backend._mutex);
+            auto previousRate = _config.rate;
+            _config.generation = _backend._generation.load(std::memory_order_relaxed);
+            _config.registers = _backend._registers;
+            _config.inputs = _backend._inputs;
+            _config.scanCalibration = _backend._scanCalibration;
+            _config.scanCalibrated = _backend._scanCalibrated;
+            _config.mockMode = _backend._mockMode;
+            _config.bufferEnabled = _backend._bufferEnabled;
+            _config.externalVref = _backend._externalVref;
+            _config.dropProbability = _backend._dropProbability;
+            _config.scanLimit = _backend._scanLimit;
+            _config.pacing = _backend._pacing;
+            _config.rate = _backend._rateOverride > 0 ? _backend._rateOverride :
+                DATA_RATES_SPS[reg(ADS114S0XBRegister::DATARATE) & 0x0f];
+            // Keep the simulated clock continuous across a rate change
+            if (_scanIndex && previousRate != _config.rate) {
+                auto elapsed = std::chrono::duration<double>(static_cast<double>(_scanIndex) / previousRate);
+                _epoch += std::chrono::duration_cast<std::chrono::steady_clock::duration>(elapsed);
+                _epochNs += static_cast<int64_t>(elapsed.count() * 1e9);
+                _scanIndex = 0;
+            }
+
+            _lsb = lsbFor(_config.registers, _config.externalVref);
+            // Like the driver, a multi-channel scan over the table loads
+            // each channel's words when it switches to it
+            for (size_t c = 0; c < AINCOM; c++) {
+                const uint8_t *words = _channels.size() > 1 && _config.scanCalibrated ?
+                    _config.scanCalibration[c].data() : &_config.registers[OFCAL0];
+                _ofcal[c] = static_cast<int16_t>(words[1] << 8 | words[0]);
+                _fscal[c] = static_cast<uint16_t>(words[4] << 8 | words[3]) / 16384.0;
+            }
+        }
+
+        uint8_t reg(ADS114S0XBRegister id) const {
+            return _config.registers[describe(id).address];
+        }
+
+        double input(size_t index, double t) {
+            if (index >= _config.inputs.size()) {
+                return 0.0;
+            }
+            const auto &w = _config.inputs[index];
+            auto v = w.valueAt(t);
+            return w.noise > 0 ? v + w.noise * _normal(_rng) : v;
+        }
+
+        int16_t convert(int channel, double t) {
+            if (_config.mockMode) {
+                return static_cast<int16_t>(_mockCounter++);
+            }
+            uint8_t mux = _channels.size() == 1 ? reg(ADS114S0XBRegister::INPMUX) : static_cast<uint8_t>(channel);
+            auto v = input(mux >> 4, t) - input(mux & 0x0f, t);
+            auto code = std::round((v / _lsb - _ofcal[channel]) * _fscal[channel]);
+            return static_cast<int16_t>(std::clamp(code, -32768.0, 32767.0));
+        }
+    };
+
+    size_t _numInputs;
+    mutable std::mutex _mutex;
+    std::atomic<uint64_t> _generation{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::array<uint8_t, NUM_REGISTERS> _registers{};
+    std::array<CalibrationEntry, AINCOM> _calibration{};
+    std::array<bool, AINCOM> _calibrationValid{};
+    // Taken at enable: OFCAL0..FSCAL1 to restore, and what the scan loads
+    CalibrationEntry _calibrationSaved{};
+    std::array<CalibrationEntry, AINCOM> _scanCalibration{};
+    bool _scanCalibrated = false;
+    std::vector<Waveform> _inputs;
+    std::vector<int> _channels;
+    bool _mockMode = false;
+    bool _bufferEnabled = false;
+    double _rateOverride = 0.0;
+    double _externalVref = ConversionParams::INTERNAL_VREF;
+    double _dropProbability = 0.0;
+    uint64_t _scanLimit = 0;
+    Pacing _pacing = Pacing::RealTime;
+    int _last_errno = 0;
+
+    // Volts per code at the PGA and REF settings in registers.
+    static double lsbFor(const std::array<uint8_t, NUM_REGISTERS> &registers, double externalVref) {
+        RegisterValue<ADS114S0XBRegister::PGA> pga{registers[describe(ADS114S0XBRegister::PGA).address]};
+        RegisterValue<ADS114S0XBRegister::REF> ref{registers[describe(ADS114S0XBRegister::REF).address]};
+        double gain = pga.get<Pga::Mode>() == Pga::Mode::Enabled ?
+            static_cast<double>(1u << static_cast<unsigned>(pga.get<Pga::Gain>())) : 1.0;
+        auto select = ref.get<Ref::Select>();
+        double vref = select == Ref::Select::Refp0Refn0 || select == Ref::Select::Refp1Refn1 ?
+            externalVref : ConversionParams::INTERNAL_VREF;
+        return vref / (gain * 32768.0);
+    }
+
+    // "calibrate" on the INPMUX input pair: SYOCAL takes the averaged input
+    // as the offset, SYGCAL scales it to positive full scale, SFOCAL shorts
+    // the inputs, which gives 0 on an ideal chip. Noise is left out.
+    bool calibrate(const std::string &value) {
+        std::string command(value.substr(0, value.find_first_of(" \n")));
+        std::unique_lock lock(_mutex);
+        if (_bufferEnabled) {
+            _last_errno = EBUSY;
+            return false;
+        }
+        auto at = [&](ADS114S0XBRegister id) -> uint8_t & {
+            return _registers[describe(id).address];
+        };
+        RegisterValue<ADS114S0XBRegister::SYS> sys{at(ADS114S0XBRegister::SYS)};
+        auto samples = CALIBRATION_SAMPLES[static_cast<unsigned>(sys.get<Sys::CalibrationSamples>())];
+        double rate = _rateOverride > 0 ? _rateOverride : DATA_RATES_SPS[at(ADS114S0XBRegister::DATARATE) & 0x0f];
+        auto mux = at(ADS114S0XBRegister::INPMUX);
+        double codes = 0.0;
+        for (unsigned i = 0; i < samples; i++) {
+            double t = (i + 1) / rate;
+            auto input = [&](size_t index) {
+                return index < _inputs.size() ? _inputs[index].valueAt(t) : 0.0;
+            };
+            codes += (input(mux >> 4) - input(mux & 0x0f)) / lsbFor(_registers, _externalVref);
+        }
+        codes /= samples;
+
+        if (command == "SYOCAL" || command == "SFOCAL") {
+            auto offset = command == "SYOCAL" ?
+                static_cast<int16_t>(std::clamp(std::round(codes), -32768.0, 32767.0)) : int16_t{0};
+            at(ADS114S0XBRegister::OFCAL0) = static_cast<uint8_t>(offset);
+            at(ADS114S0XBRegister::OFCAL1) = static_cast<uint8_t>(static_cast<uint16_t>(offset) >> 8);
+        }
+        else if (command == "SYGCAL") {
+            double span = codes - static_cast<int16_t>(at(ADS114S0XBRegister::OFCAL1) << 8 | at(ADS114S0XBRegister::OFCAL0));
+            if (span <= 0) {
+                _last_errno = EINVAL;
+                return false;
+            }
+            auto scale = static_cast<uint16_t>(std::clamp(std::round(16384.0 * 32767.0 / span), 0.0, 65535.0));
+            at(ADS114S0XBRegister::FSCAL0) = static_cast<uint8_t>(scale);
+            at(ADS114S0XBRegister::FSCAL1) = static_cast<uint8_t>(scale >> 8);
+        }
+        else {
+            _last_errno = EINVAL;
+            return false;
+        }
+        _generation++;
+        bool realTime = _pacing == Pacing::RealTime;
+        lock.unlock();
+
+        // The averaged conversions plus the one the command restarts
+        if (realTime) {
+            std::this_thread::sleep_for(std::chrono::duration<double>((samples + 1) / rate));
+        }
+        return true;
+    }
+
+    static int scanEnableChannel(const std::string &name) {
+        int channel;
+        char tail[4];
+        if (sscanf(name.c_str(), "scan_elements/in_voltage%d_%3s", &channel, tail) == 2 &&
+                std::string_view(tail) == "en") {
+            return channel;
+        }
+        return -1;
+    }
+
+    static int registerAddress(const std::string &name) {
+        for (auto &reg : REGISTER_DESCRIPTORS) {
+            if (reg.name == name && reg.address < NUM_REGISTERS) {
+                return reg.address;
+            }
+        }
+        return -1;
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace adcs
+{
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Lock-free single-producer/single-consumer ring. Producer and consumer
+// indices live on separate cache lines, and each side keeps a cached copy
+// of the other's index so the shared line is only touched when the cached
+// value says the ring looks full (or empty).
+template <typename T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity) :
+        _slots(roundUpPow2(std::max<size_t>(capacity, 2))),
+        _mask(_slots.size() - 1) {
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side. Returns how many items were queued.
+    size_t tryPushBatch(const T *items, size_t count) {
+        auto head = _head.load(std::memory_order_relaxed);
+        auto free = _slots.size() - (head - _cachedTail);
+        if (free < count) {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            free = _slots.size() - (head - _cachedTail);
+        }
+        count = std::min(count, free);
+        for (size_t i = 0; i < count; i++) {
+            _slots[(head + i) & _mask] = items[i];
+        }
+        _head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    bool tryPush(const T &item) {
+        return tryPushBatch(&item, 1) == 1;
+    }
+
+    // Consumer side. Returns how many items were dequeued into out.
+    size_t tryPopBatch(T *out, size_t max) {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto available = _cachedHead - tail;
+        if (available < max) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            available = _cachedHead - tail;
+        }
+        auto count = std::min(max, available);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = _slots[(tail + i) & _mask];
+        }
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool tryPop(T &item) {
+        return tryPopBatch(&item, 1) == 1;
+    }
+
+    // Approximate when called concurrently with push/pop.
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return _slots.size();
+    }
+
+private:
+    std::vector<T> _slots;
+    const size_t _mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0};
+    size_t _cachedTail = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0};
+    size_t _cachedHead = 0;
+
+    static size_t roundUpPow2(size_t value) {
+        size_t pow2 = 1;
+        while (pow2 < value) {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+};
+
+} // namespace adcs
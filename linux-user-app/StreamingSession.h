@@ -0,0 +1,263 @@
+#pragma once
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IIOSysfsFilesUtil.h"
+#include "Metrics.h"
+#include "SampleSource.h"
+#include "ScanDecoder.h"
+
+namespace adcs
+{
+// Keeps the trigger and the buffer character device open for the whole
+// acquisition, so a sampling loop costs one pwrite() and one read() per
+// sample instead of an open/close pair and a heap allocation each.
+class StreamingSession {
+public:
+    explicit StreamingSession(const IIOSysfsFilesUtil &iioSysfs = IIOSysfsFilesUtil()) :
+        StreamingSession(iioSysfs.getTrigger(), iioSysfs.getBufferInterface()) {
+        _triggerValue = iioSysfs.getFlagOn();
+    }
+
+    StreamingSession(const std::string &triggerPath, const std::string &bufferPath) :
+        _triggerPath(triggerPath),
+        _bufferPath(bufferPath) {
+    }
+
+    StreamingSession(const StreamingSession &) = delete;
+    StreamingSession &operator=(const StreamingSession &) = delete;
+
+    StreamingSession(StreamingSession &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    StreamingSession &operator=(StreamingSession &&other) noexcept {
+        if (this != &other) {
+            close();
+            _triggerPath = std::move(other._triggerPath);
+            _bufferPath = std::move(other._bufferPath);
+            _triggerValue = std::move(other._triggerValue);
+            _triggerFd = std::exchange(other._triggerFd, -1);
+            _bufferFd = std::exchange(other._bufferFd, -1);
+            _last_errno = other._last_errno;
+            _pollTimeoutMs = other._pollTimeoutMs;
+            _raw = std::move(other._raw);
+            _metrics = other._metrics;
+            _triggeredAt = other._triggeredAt;
+        }
+        return *this;
+    }
+
+    ~StreamingSession() {
+        close();
+    }
+
+    // Same convention as ADS114S0XB::initialize(): {errno, failing call}.
+    std::pair<int, std::string> open() {
+        if (isOpen()) {
+            return {0, "already open"};
+        }
+        _triggerFd = ::open(_triggerPath.c_str(), O_WRONLY | O_CLOEXEC);
+        if (_triggerFd < 0) {
+            _last_errno = errno;
+            return {_last_errno, "open " + _triggerPath};
+        }
+        _bufferFd = ::open(_bufferPath.c_str(), O_RDONLY | O_CLOEXEC | (_pollTimeoutMs >= 0 ? O_NONBLOCK : 0));
+        if (_bufferFd < 0) {
+            _last_errno = errno;
+            close();
+            return {_last_errno, "open " + _bufferPath};
+        }
+        return {0, ""};
+    }
+
+    void close() {
+        if (_triggerFd >= 0) {
+            ::close(_triggerFd);
+            _triggerFd = -1;
+        }
+        if (_bufferFd >= 0) {
+            ::close(_bufferFd);
+            _bufferFd = -1;
+        }
+    }
+
+    bool isOpen() const {
+        return _triggerFd >= 0 && _bufferFd >= 0;
+    }
+
+    // Records into metrics from now on, nullptr to stop. Trigger-to-data
+    // latency is only measured for conversions fired by triggerConversion().
+    void setMetrics(Metrics *metrics) {
+        _metrics = metrics;
+        _triggeredAt = 0;
+    }
+
+    // Batched wakeups: with timeoutMs >= 0 every read first poll()s until
+    // the buffer holds its watermark (see ADS114S0XB::setBufferWatermark())
+    // or timeoutMs has passed with at least one record waiting, then drains
+    // them with a single non-blocking read(). The timeout bounds the latency
+    // of a partial batch. -1 (the default) reads blocking.
+    void setPollTimeout(int timeoutMs) {
+        _pollTimeoutMs = timeoutMs;
+        if (_bufferFd >= 0) {
+            auto flags = ::fcntl(_bufferFd, F_GETFL);
+            ::fcntl(_bufferFd, F_SETFL, timeoutMs >= 0 ? flags | O_NONBLOCK : flags & ~O_NONBLOCK);
+        }
+    }
+
+    // sysfs attributes are rewound per write, pwrite at offset 0 keeps
+    // the descriptor reusable without an lseek().
+    bool triggerConversion() {
+        auto ret = ::pwrite(_triggerFd, _triggerValue.data(), _triggerValue.size(), 0);
+        if (ret < 0) {
+            _last_errno = errno;
+            if (METRICS_ENABLED && _metrics) {
+                _metrics->triggerErrors.add();
+            }
+            return false;
+        }
+        if (METRICS_ENABLED && _metrics) {
+            _metrics->triggers.add();
+            if (_triggeredAt == 0) {
+                _triggeredAt = metricsNow(); // oldest conversion not yet read
+            }
+        }
+        return true;
+    }
+
+    // Reads into caller-provided storage. Returns the number of bytes read,
+    // or -1 with getLastErrno() set.
+    ssize_t readBuffer(std::span<uint8_t> data) {
+        if (METRICS_ENABLED && _metrics) {
+            return readBufferInstrumented(data);
+        }
+        auto ret = readOnce(data);
+        if (ret < 0) {
+            _last_errno = errno;
+        }
+        return ret;
+    }
+
+    // Pulls up to block.capacity() records with a single read() and decodes
+    // them in place. Returns the number of records, or -1 on error.
+    ssize_t readRecords(const ScanDecoder &decoder, SampleBlock &block) {
+        size_t bytes = block.capacity() * decoder.recordSize();
+        if (_raw.size() < bytes) {
+            _raw.resize(bytes);
+        }
+        auto ret = readBuffer({_raw.data(), bytes});
+        if (ret < 0) {
+            block.size = 0;
+            return ret;
+        }
+        if (METRICS_ENABLED && _metrics) {
+            auto start = metricsNow();
+            auto scans = decoder.decode({_raw.data(), static_cast<size_t>(ret)}, block);
+            _metrics->decode.recordSince(start);
+            _metrics->scansDecoded.add(block.size);
+            return scans;
+        }
+        return decoder.decode({_raw.data(), static_cast<size_t>(ret)}, block);
+    }
+
+    int getBufferFd() const {
+        return _bufferFd;
+    }
+
+    int getLastErrno() const {
+        return _last_errno;
+    }
+
+private:
+    std::string _triggerPath;
+    std::string _bufferPath;
+    std::string _triggerValue{"1"};
+    int _triggerFd = -1;
+    int _bufferFd = -1;
+    int _last_errno = 0;
+    int _pollTimeoutMs = -1;
+    std::vector<uint8_t> _raw;
+    Metrics *_metrics = nullptr;
+    int64_t _triggeredAt = 0;
+
+    // In poll mode an empty buffer after the timeout just means waiting
+    // again: returning 0 would read as end of stream.
+    ssize_t readOnce(std::span<uint8_t> data) {
+        for (;;) {
+            if (_pollTimeoutMs >= 0) {
+                pollfd pfd{_bufferFd, POLLIN, 0};
+                if (::poll(&pfd, 1, _pollTimeoutMs) < 0 && errno != EINTR) {
+                    return -1;
+                }
+            }
+            auto ret = ::read(_bufferFd, data.data(), data.size());
+            if (ret >= 0 || (errno != EINTR && !(errno == EAGAIN && _pollTimeoutMs >= 0))) {
+                return ret;
+            }
+        }
+    }
+
+    ssize_t readBufferInstrumented(std::span<uint8_t> data) {
+        auto start = metricsNow();
+        auto ret = readOnce(data);
+        auto end = metricsNow();
+        if (ret < 0) {
+            _last_errno = errno;
+            _metrics->readErrors.add();
+            return ret;
+        }
+        _metrics->readSyscall.record(static_cast<uint64_t>(end - start));
+        _metrics->reads.add();
+        _metrics->bytesRead.add(static_cast<uint64_t>(ret));
+        if (static_cast<size_t>(ret) < data.size()) {
+            _metrics->shortReads.add();
+        }
+        if (_triggeredAt != 0 && ret > 0) {
+            _metrics->triggerToData.record(static_cast<uint64_t>(end - _triggeredAt));
+            _triggeredAt = 0;
+        }
+        return ret;
+    }
+};
+
+// SampleSource over an open StreamingSession. With a sysfs trigger every
+// scan has to be requested, so triggersPerRead conversions are fired before
+// each batched read; leave it at 0 when the device has its own trigger.
+class StreamingSource : public SampleSource {
+public:
+    StreamingSource(StreamingSession &session, const ScanDecoder &decoder, size_t triggersPerRead = 0) :
+        _session(session),
+        _decoder(decoder),
+        _triggersPerRead(triggersPerRead) {
+    }
+
+    void prepare(SampleBlock &block, size_t capacity) override {
+        _decoder.prepare(block, capacity);
+    }
+
+    ssize_t read(SampleBlock &block) override {
+        for (size_t i = 0; i < _triggersPerRead; i++) {
+            if (!_session.triggerConversion()) {
+                return -1;
+            }
+        }
+        return _session.readRecords(_decoder, block);
+    }
+
+private:
+    StreamingSession &_session;
+    ScanDecoder _decoder;
+    size_t _triggersPerRead;
+};
+
+} // namespace adcs
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "AdcBackend.h"
+#include "IIOSysfsFilesUtil.h"
+#include "StreamingSession.h"
+
+namespace adcs
+{
+// The kernel driver through its sysfs and /dev files only, no libiio.
+// Every path comes from IIOSysfsFilesUtil, so a fake tree under a root
+// directory stands in for the real one (see bench/io-bench.cpp).
+class SysfsBackend : public AdcBackend {
+public:
+    explicit SysfsBackend(const IIOSysfsFilesUtil &iioSysfs = IIOSysfsFilesUtil()) :
+        _iioSysfs(iioSysfs) {
+    }
+
+    std::pair<int, std::string> open(const std::string & = "") override {
+        if (::access(_iioSysfs.getDeviceDir().c_str(), F_OK) < 0) {
+            _last_errno = errno;
+            return {_last_errno, "access " + _iioSysfs.getDeviceDir()};
+        }
+        return {0, ""};
+    }
+
+    std::optional<std::string> readAttribute(const std::string &name) override {
+        char buf[128];
+        int fd = ::open((_iioSysfs.getDeviceDir() + name).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            _last_errno = errno;
+            return std::nullopt;
+        }
+        auto ret = ::pread(fd, buf, sizeof buf - 1, 0);
+        if (ret < 0) {
+            _last_errno = errno;
+        }
+        ::close(fd);
+        if (ret < 0) {
+            return std::nullopt;
+        }
+        return std::string(buf, static_cast<size_t>(ret));
+    }
+
+    // O_TRUNC is ignored by sysfs and keeps stand-in files from a fake tree
+    // from holding leftovers of a longer previous value.
+    bool writeAttribute(const std::string &name, const std::string &value) override {
+        int fd = ::open((_iioSysfs.getDeviceDir() + name).c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+        if (fd < 0) {
+            _last_errno = errno;
+            return false;
+        }
+        auto ret = ::pwrite(fd, value.data(), value.size(), 0);
+        if (ret < 0) {
+            _last_errno = errno;
+        }
+        ::close(fd);
+        return ret >= 0;
+    }
+
+    // Through the driver's binary "registers" file: one SPI transfer for
+    // the whole block instead of one per register.
+    std::optional<size_t> readRegisterBlock(uint8_t first, std::span<uint8_t> values) override {
+        return transferBlock(_iioSysfs.getRegisterMap(), first, values.data(), values.size(), false);
+    }
+
+    std::optional<size_t> writeRegisterBlock(uint8_t first, std::span<const uint8_t> values) override {
+        return transferBlock(_iioSysfs.getRegisterMap(), first, const_cast<uint8_t *>(values.data()),
+            values.size(), true);
+    }
+
+    // The driver's binary "calibration" file, offset channel * 5.
+    std::optional<size_t> writeCalibrationTable(int firstChannel, std::span<const uint8_t> entries) override {
+        if (firstChannel < 0) {
+            _last_errno = EINVAL;
+            return std::nullopt;
+        }
+        return transferBlock(_iioSysfs.getCalibrationTable(),
+            static_cast<off_t>(firstChannel) * CALIBRATION_ENTRY_SIZE,
+            const_cast<uint8_t *>(entries.data()), entries.size(), true);
+    }
+
+    std::optional<ScanLayout> scanLayout() override {
+        return ScanLayout::fromScanElementsDir(_iioSysfs.getScanElementsDir());
+    }
+
+    // Streams /dev/iio:deviceN with a StreamingSession. The channels are
+    // enabled in scan_elements/ and the buffer is enabled until the source
+    // is destroyed.
+    std::unique_ptr<SampleSource> createSampleSource(const std::vector<int> &channels,
+            size_t samplesPerRead) override {
+        writeAttribute(_iioSysfs.getBufferEnable(), _iioSysfs.getFlagOff());
+        for (auto channel : channels) {
+            if (!writeAttribute(_iioSysfs.getVoltageEnable(channel), _iioSysfs.getFlagOn())) {
+                return nullptr;
+            }
+        }
+        auto layout = scanLayout();
+        if (!layout || layout->recordSize() == 0) {
+            _last_errno = layout ? ENODATA : _last_errno;
+            return nullptr;
+        }
+        if (!writeAttribute(_iioSysfs.getBufferEnable(), _iioSysfs.getFlagOn())) {
+            return nullptr;
+        }
+        auto source = std::make_unique<Source>(*this, *layout, samplesPerRead, _triggersPerRead);
+        source->session.setPollTimeout(_pollTimeoutMs);
+        if (auto status = source->session.open(); status.first != 0) {
+            _last_errno = status.first;
+            return nullptr;
+        }
+        return source;
+    }
+
+    // With the sysfs trigger every scan has to be requested; see
+    // StreamingSource. 0 (the default) suits the driver's DRDY trigger.
+    void setTriggersPerRead(size_t triggersPerRead) {
+        _triggersPerRead = triggersPerRead;
+    }
+
+    // Poll mode of the sources' sessions, see StreamingSession::setPollTimeout().
+    void setPollTimeout(int timeoutMs) {
+        _pollTimeoutMs = timeoutMs;
+    }
+
+    int getLastErrno() const override {
+        return _last_errno;
+    }
+
+    const IIOSysfsFilesUtil &getSysfs() const {
+        return _iioSysfs;
+    }
+
+protected:
+    IIOSysfsFilesUtil _iioSysfs;
+    int _last_errno = 0;
+
+private:
+    size_t _triggersPerRead = 0;
+    int _pollTimeoutMs = -1;
+
+    struct Source : SampleSource {
+        Source(SysfsBackend &backend, const ScanLayout &layout, size_t samplesPerRead, size_t triggersPerRead) :
+            backend(backend),
+            session(backend.getSysfs()),
+            decoder(layout),
+            stream(session, decoder, triggersPerRead),
+            samplesPerRead(std::max<size_t>(samplesPerRead, 1)) {
+        }
+
+        ~Source() override {
+            session.close();
+            backend.writeAttribute(backend.getSysfs().getBufferEnable(), backend.getSysfs().getFlagOff());
+        }
+
+        void prepare(SampleBlock &block, size_t capacity) override {
+            stream.prepare(block, std::min(capacity, samplesPerRead));
+        }
+
+        ssize_t read(SampleBlock &block) override {
+            auto ret = stream.read(block);
+            if (ret < 0) {
+                errno = session.getLastErrno();
+            }
+            return ret;
+        }
+
+        void setMetrics(Metrics *metrics) override {
+            session.setMetrics(metrics);
+        }
+
+        SysfsBackend &backend;
+        StreamingSession session;
+        ScanDecoder decoder;
+        StreamingSource stream;
+        size_t samplesPerRead;
+    };
+
+    // One pread/pwrite on a binary attribute, offset as the driver defines it.
+    std::optional<size_t> transferBlock(const std::string &path, off_t offset, uint8_t *values, size_t count,
+            bool write) {
+        int fd = ::open(path.c_str(), (write ? O_WRONLY : O_RDONLY) | O_CLOEXEC);
+        if (fd < 0) {
+            _last_errno = errno;
+            return std::nullopt;
+        }
+        auto ret = write ? ::pwrite(fd, values, count, offset) : ::pread(fd, values, count, offset);
+        if (ret < 0) {
+            _last_errno = errno;
+        }
+        ::close(fd);
+        if (ret < 0) {
+            return std::nullopt;
+        }
+        return static_cast<size_t>(ret);
+    }
+};
+
+} // namespace adcs
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ADS114S0XB_SIMD_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ADS114S0XB_SIMD_NEON 1
+#endif
+
+#include "ADS114S0XBRegisters.h"
+#include "SampleBlock.h"
+
+namespace adcs
+{
+// Struct-of-arrays batch of converted samples, column for column the same
+// as the SampleBlock it was converted from.
+template <typename T>
+struct BasicVoltageBlock {
+    std::vector<int> channelIds;
+    std::vector<std::vector<T>> channels;
+    std::vector<int64_t> timestamps;
+    size_t size = 0;
+
+    void reset(const std::vector<int> &ids, size_t capacity) {
+        channelIds = ids;
+        channels.resize(ids.size());
+        for (auto &column : channels) {
+            column.resize(capacity);
+        }
+        timestamps.resize(capacity);
+        size = 0;
+    }
+
+    size_t capacity() const {
+        return timestamps.size();
+    }
+
+    size_t channelCount() const {
+        return channels.size();
+    }
+
+    std::span<T> column(size_t i) {
+        return {channels[i].data(), size};
+    }
+
+    std::span<const T> column(size_t i) const {
+        return {channels[i].data(), size};
+    }
+};
+
+using VoltageBlock = BasicVoltageBlock<float>;
+using VoltageBlockF64 = BasicVoltageBlock<double>;
+
+// volts = code * scale + offset, one multiply-add per sample.
+struct ConversionParams {
+    double scale = INTERNAL_VREF / 32768.0;
+    double offset = 0.0;
+
+    static constexpr double INTERNAL_VREF = 2.5;
+
+    // Builds the transfer function from the register contents. The LSB is
+    // VREF / (gain * 2^15); gain is 1 when the PGA is bypassed and VREF is
+    // the internal 2.5 V reference unless REF selects REFP0/REFP1, in which
+    // case externalVref is used.
+    //
+    // The ADC applies OFCAL and FSCAL itself before a code reaches the
+    // buffer, so they are only folded in (code - OFCAL) * FSCAL / 0x4000
+    // when softwareCalibration is set, for codes that skipped the on-chip
+    // correction (the driver's mock mode, or captures of uncorrected data).
+    static ConversionParams fromRegisters(RegisterValue<ADS114S0XBRegister::PGA> pga,
+            RegisterValue<ADS114S0XBRegister::REF> ref, int16_t ofcal = 0, uint16_t fscal = 0x4000,
+            double externalVref = INTERNAL_VREF, bool softwareCalibration = false) {
+        double gain = 1.0;
+        if (pga.get<Pga::Mode>() == Pga::Mode::Enabled) {
+            gain = static_cast<double>(1u << static_cast<unsigned>(pga.get<Pga::Gain>()));
+        }
+        auto select = ref.get<Ref::Select>();
+        double vref = select == Ref::Select::Refp0Refn0 || select == Ref::Select::Refp1Refn1 ?
+            externalVref : INTERNAL_VREF;
+
+        ConversionParams params;
+        params.scale = vref / (gain * 32768.0);
+        if (softwareCalibration) {
+            params.scale *= fscal / 16384.0;
+            params.offset = -ofcal * params.scale;
+        }
+        return params;
+    }
+};
+
+enum class SimdLevel { Scalar, Sse41, Avx2, Neon };
+
+namespace detail
+{
+template <typename T>
+inline void convertScalar(const int16_t *in, T *out, size_t n, T scale, T offset) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<T>(in[i]) * scale + offset;
+    }
+}
+
+// The vector paths use a separate multiply and add rather than FMA, so they
+// round like convertScalar() as long as the compiler does not contract it.
+#ifdef ADS114S0XB_SIMD_X86
+__attribute__((target("sse4.1")))
+inline void convertSse41(const int16_t *in, float *out, size_t n, float scale, float offset) {
+    auto vscale = _mm_set1_ps(scale);
+    auto voffset = _mm_set1_ps(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto codes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        auto lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(codes));
+        auto hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(codes, 8)));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(lo, vscale), voffset));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_mul_ps(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+
+__attribute__((target("sse4.1")))
+inline void convertSse41(const int16_t *in, double *out, size_t n, double scale, double offset) {
+    auto vscale = _mm_set1_pd(scale);
+    auto voffset = _mm_set1_pd(offset);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto codes = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i)));
+        auto lo = _mm_cvtepi32_pd(codes);
+        auto hi = _mm_cvtepi32_pd(_mm_srli_si128(codes, 8));
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(lo, vscale), voffset));
+        _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_mul_pd(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+
+__attribute__((target("avx2")))
+inline void convertAvx2(const int16_t *in, float *out, size_t n, float scale, float offset) {
+    auto vscale = _mm256_set1_ps(scale);
+    auto voffset = _mm256_set1_ps(offset);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto codes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        auto lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(codes)));
+        auto hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(codes, 1)));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(lo, vscale), voffset));
+        _mm256_storeu_ps(out + i + 8, _mm256_add_ps(_mm256_mul_ps(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+
+__attribute__((target("avx2")))
+inline void convertAvx2(const int16_t *in, double *out, size_t n, double scale, double offset) {
+    auto vscale = _mm256_set1_pd(scale);
+    auto voffset = _mm256_set1_pd(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto codes = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+        auto lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(codes));
+        auto hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(codes, 1));
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(lo, vscale), voffset));
+        _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_mul_pd(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+#endif
+
+#ifdef ADS114S0XB_SIMD_NEON
+inline void convertNeon(const int16_t *in, float *out, size_t n, float scale, float offset) {
+    auto vscale = vdupq_n_f32(scale);
+    auto voffset = vdupq_n_f32(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto codes = vld1q_s16(in + i);
+        auto lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(codes)));
+        auto hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(codes)));
+        vst1q_f32(out + i, vaddq_f32(vmulq_f32(lo, vscale), voffset));
+        vst1q_f32(out + i + 4, vaddq_f32(vmulq_f32(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+
+#ifdef __aarch64__
+inline void convertNeon(const int16_t *in, double *out, size_t n, double scale, double offset) {
+    auto vscale = vdupq_n_f64(scale);
+    auto voffset = vdupq_n_f64(offset);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto codes = vmovl_s16(vld1_s16(in + i));
+        auto lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(codes)));
+        auto hi = vcvtq_f64_s64(vmovl_s32(vget_high_s32(codes)));
+        vst1q_f64(out + i, vaddq_f64(vmulq_f64(lo, vscale), voffset));
+        vst1q_f64(out + i + 2, vaddq_f64(vmulq_f64(hi, vscale), voffset));
+    }
+    convertScalar(in + i, out + i, n - i, scale, offset);
+}
+#else
+inline void convertNeon(const int16_t *in, double *out, size_t n, double scale, double offset) {
+    convertScalar(in, out, n, scale, offset);
+}
+#endif
+#endif
+} // namespace detail
+
+// Best level this CPU supports, probed once.
+inline SimdLevel detectSimdLevel() {
+    static const SimdLevel level = [] {
+#if defined(ADS114S0XB_SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return SimdLevel::Sse41;
+        }
+        return SimdLevel::Scalar;
+#elif defined(ADS114S0XB_SIMD_NEON)
+        return SimdLevel::Neon;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }();
+    return level;
+}
+
+// Converts codes to volts, out must hold at least codes.size() elements.
+// level defaults to the best supported one; a level the build or CPU
+// lacks falls back to the scalar loop.
+template <typename T>
+void convertCodes(std::span<const int16_t> codes, std::span<T> out, const ConversionParams &params,
+        SimdLevel level = detectSimdLevel()) {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "float or double output");
+    auto n = std::min(codes.size(), out.size());
+    auto scale = static_cast<T>(params.scale);
+    auto offset = static_cast<T>(params.offset);
+    if (level > detectSimdLevel()) {
+        level = SimdLevel::Scalar;
+    }
+    switch (level) {
+#ifdef ADS114S0XB_SIMD_X86
+    case SimdLevel::Avx2:
+        return detail::convertAvx2(codes.data(), out.data(), n, scale, offset);
+    case SimdLevel::Sse41:
+        return detail::convertSse41(codes.data(), out.data(), n, scale, offset);
+#endif
+#ifdef ADS114S0XB_SIMD_NEON
+    case SimdLevel::Neon:
+        return detail::convertNeon(codes.data(), out.data(), n, scale, offset);
+#endif
+    default:
+        return detail::convertScalar(codes.data(), out.data(), n, scale, offset);
+    }
+}
+
+// Converts whole decoded blocks. Every channel uses the default parameters
+// unless it was given its own with setChannelParams(), e.g. after a
+// per-channel gain change.
+class VoltageConverter {
+public:
+    explicit VoltageConverter(const ConversionParams &params = ConversionParams()) :
+        _defaultParams(params) {
+    }
+
+    void setDefaultParams(const ConversionParams &params) {
+        _defaultParams = params;
+    }
+
+    void setChannelParams(int channelId, const ConversionParams &params) {
+        if (channelId < 0) {
+            return;
+        }
+        if (static_cast<size_t>(channelId) >= _channelParams.size()) {
+            _channelParams.resize(channelId + 1);
+            _hasChannelParams.resize(channelId + 1, false);
+        }
+        _channelParams[channelId] = params;
+        _hasChannelParams[channelId] = true;
+    }
+
+    const ConversionParams &paramsFor(int channelId) const {
+        if (channelId >= 0 && static_cast<size_t>(channelId) < _channelParams.size() &&
+                _hasChannelParams[channelId]) {
+            return _channelParams[channelId];
+        }
+        return _defaultParams;
+    }
+
+    // Sizes out like block; only needed once per acquisition.
+    template <typename T>
+    void prepare(const SampleBlock &block, BasicVoltageBlock<T> &out) const {
+        out.reset(block.channelIds, block.capacity());
+    }
+
+    // Converts block.size scans into out, which must have been prepared
+    // for the same channels. Returns the number of scans converted.
+    template <typename T>
+    size_t convert(const SampleBlock &block, BasicVoltageBlock<T> &out,
+            SimdLevel level = detectSimdLevel()) const {
+        auto n = std::min(block.size, out.capacity());
+        for (size_t c = 0; c < block.channelCount() && c < out.channelCount(); c++) {
+            convertCodes<T>({block.channels[c].data(), n}, {out.channels[c].data(), n},
+                paramsFor(block.channelIds[c]), level);
+        }
+        std::copy_n(block.timestamps.begin(), n, out.timestamps.begin());
+        out.size = n;
+        return n;
+    }
+
+private:
+    ConversionParams _defaultParams;
+    std::vector<ConversionParams> _channelParams;
+    std::vector<bool> _hasChannelParams;
+};
+
+} // namespace adcs
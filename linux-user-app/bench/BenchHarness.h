@@ -0,0 +1,228 @@
+// Shared measurement and reporting for the benchmarks: ns/op, items/s,
+// heap allocations per op and latency percentiles, printed as a table and
+// optionally written as JSON (--json <file>, "-" for stdout) so runs can
+// be compared across releases. --filter <text> runs matching cases only.
+//
+// Counts allocations by replacing the global operator new, so include it
+// from exactly one translation unit per benchmark binary.
+#pragma once
+
+#include <sys/utsname.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+inline std::atomic<uint64_t> allocations{0};
+}
+
+// noinline keeps GCC from pairing the malloc/free inside with new/delete
+// expressions and flagging them as mismatched.
+__attribute__((noinline)) void *operator new(size_t size) {
+  bench::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace bench
+{
+struct Result {
+  std::string name;
+  uint64_t ops = 0;
+  uint64_t items = 0;
+  double seconds = 0;
+  double nsPerOp = 0;
+  double itemsPerSecond = 0;
+  double allocationsPerOp = 0;
+  double p50 = 0, p90 = 0, p99 = 0, max = 0; // ns per op
+  bool failed = false;
+};
+
+class Suite {
+public:
+  Suite(const char *name, int argc, char **argv) : _name(name) {
+    for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+        _jsonPath = argv[++i];
+      }
+      else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+        _filter = argv[++i];
+      }
+    }
+  }
+
+  bool enabled(const std::string &name) const {
+    return _filter.empty() || name.find(_filter) != std::string::npos;
+  }
+
+  // Times every call of op() separately for the percentiles; op returns
+  // false on failure, which stops the case. itemsPerOp scales items/s,
+  // e.g. samples per read.
+  template <typename F>
+  const Result &run(const std::string &name, uint64_t ops, F &&op, uint64_t itemsPerOp = 1) {
+    Result result;
+    result.name = name;
+    if (!enabled(name)) {
+      return add(result);
+    }
+    std::vector<uint64_t> latencies;
+    latencies.reserve(ops);
+    op(); // warm up page cache, dentries and lazy allocations
+
+    auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    for (uint64_t i = 0; i < ops; i++) {
+      if (!op()) {
+        result.failed = true;
+        break;
+      }
+      auto now = std::chrono::steady_clock::now();
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+      last = now;
+      result.ops++;
+    }
+    result.seconds = std::chrono::duration<double>(last - start).count();
+    auto allocated = allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    // reserve() above keeps the latency vector itself out of the count
+    result.items = result.ops * itemsPerOp;
+    finish(result, latencies, allocated);
+    return add(result);
+  }
+
+  // For cases that report their own item count per call, e.g. a read
+  // that returns however many scans were available. op returns the item
+  // count, or a negative value on failure.
+  template <typename F>
+  const Result &runCounted(const std::string &name, uint64_t ops, F &&op) {
+    Result result;
+    result.name = name;
+    if (!enabled(name)) {
+      return add(result);
+    }
+    std::vector<uint64_t> latencies;
+    latencies.reserve(ops);
+
+    auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    for (uint64_t i = 0; i < ops; i++) {
+      auto items = op();
+      if (items <= 0) {
+        result.failed = items < 0;
+        break;
+      }
+      auto now = std::chrono::steady_clock::now();
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+      last = now;
+      result.ops++;
+      result.items += static_cast<uint64_t>(items);
+    }
+    result.seconds = std::chrono::duration<double>(last - start).count();
+    finish(result, latencies, allocations.load(std::memory_order_relaxed) - allocationsBefore);
+    return add(result);
+  }
+
+  // Prints the table, writes JSON if asked. Returns the process exit code.
+  int report() const {
+    printf("%-44s %10s %12s %14s %9s %10s %10s %10s\n",
+      "case", "ops", "ns/op", "items/s", "allocs/op", "p50 ns", "p99 ns", "max ns");
+    for (const auto &r : _results) {
+      if (r.ops == 0 && !r.failed) {
+        continue;
+      }
+      printf("%-44s %10lu %12.1f %14.0f %9.2f %10.0f %10.0f %10.0f%s\n",
+        r.name.c_str(), r.ops, r.nsPerOp, r.itemsPerSecond, r.allocationsPerOp,
+        r.p50, r.p99, r.max, r.failed ? "  FAILED" : "");
+    }
+    if (!_jsonPath.empty() && !writeJson()) {
+      return EXIT_FAILURE;
+    }
+    return std::any_of(_results.begin(), _results.end(), [](const Result &r) { return r.failed; }) ?
+      EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+private:
+  std::string _name;
+  std::string _jsonPath;
+  std::string _filter;
+  std::vector<Result> _results;
+
+  const Result &add(const Result &result) {
+    _results.push_back(result);
+    return _results.back();
+  }
+
+  static double percentile(std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) {
+      return 0;
+    }
+    return static_cast<double>(sorted[static_cast<size_t>(p * (sorted.size() - 1))]);
+  }
+
+  static void finish(Result &result, std::vector<uint64_t> &latencies, uint64_t allocated) {
+    if (result.ops == 0) {
+      return;
+    }
+    result.nsPerOp = result.seconds * 1e9 / result.ops;
+    result.itemsPerSecond = result.seconds > 0 ? result.items / result.seconds : 0;
+    result.allocationsPerOp = static_cast<double>(allocated) / result.ops;
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.50);
+    result.p90 = percentile(latencies, 0.90);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = percentile(latencies, 1.0);
+  }
+
+  bool writeJson() const {
+    FILE *out = _jsonPath == "-" ? stdout : fopen(_jsonPath.c_str(), "w");
+    if (!out) {
+      perror(_jsonPath.c_str());
+      return false;
+    }
+    struct utsname host;
+    uname(&host);
+    fprintf(out, "{\n  \"suite\": \"%s\",\n  \"timestamp\": %ld,\n", _name.c_str(), static_cast<long>(time(nullptr)));
+    fprintf(out, "  \"host\": {\"machine\": \"%s\", \"release\": \"%s\"},\n", host.machine, host.release);
+    fprintf(out, "  \"results\": [");
+    bool first = true;
+    for (const auto &r : _results) {
+      if (r.ops == 0 && !r.failed) {
+        continue;
+      }
+      fprintf(out, "%s\n    {\"name\": \"%s\", \"ops\": %" PRIu64 ", \"items\": %" PRIu64 ", \"ns_per_op\": %.1f, "
+        "\"items_per_second\": %.1f, \"allocations_per_op\": %.3f, "
+        "\"p50_ns\": %.0f, \"p90_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, \"failed\": %s}",
+        first ? "" : ",", r.name.c_str(), r.ops, r.items, r.nsPerOp, r.itemsPerSecond, r.allocationsPerOp,
+        r.p50, r.p90, r.p99, r.max, r.failed ? "true" : "false");
+      first = false;
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) {
+      fclose(out);
+    }
+    return true;
+  }
+};
+
+} // namespace bench
@@ -0,0 +1,268 @@
+// AsyncSession and Reactor: one thread serving 1..16 devices through
+// coroutines, against one blocking reader thread per device, plus the
+// round trip of a register access through the reactor's worker. The fake
+// tree's /dev/iio:deviceN are FIFOs fed by a producer thread, since epoll
+// needs a pollable descriptor.
+//
+//   bench/async-bench [--json results.json] [--filter reactor/]
+#include <sys/stat.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "BenchHarness.h"
+#include "../ADS114S0XB.h"
+#include "../SysfsBackend.h"
+
+namespace fs = std::filesystem;
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+static const size_t RECORD = 16; // CHANNELS plus the timestamp
+static const uint64_t SCANS = 1 << 18; // per device and run
+static const size_t BLOCK = 256;
+static const size_t MAX_DEVICES = 16;
+
+static std::string makeFakeTree() {
+  char tmpl[] = "/tmp/ads114s0xb-async-XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    perror("mkdtemp");
+    exit(EXIT_FAILURE);
+  }
+  std::string root(tmpl);
+  fs::create_directories(root + "/dev");
+  fs::create_directories(root + "/sys/bus/iio/devices/trigger0");
+  std::ofstream(root + "/sys/bus/iio/devices/trigger0/trigger_now") << "0";
+  for (size_t d = 0; d < MAX_DEVICES; d++) {
+    auto id = "iio:device" + std::to_string(d);
+    auto dev = root + "/sys/bus/iio/devices/" + id + "/";
+    fs::create_directories(dev + "scan_elements");
+    fs::create_directories(dev + "buffer");
+    std::ofstream(dev + "buffer/enable") << "0";
+    for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+      std::ofstream(dev + std::string(reg.name)) << static_cast<unsigned>(reg.resetValue) << "\n";
+    }
+    std::vector<char> registers(0x12);
+    for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+      if (reg.address < registers.size()) {
+        registers[reg.address] = static_cast<char>(reg.resetValue);
+      }
+    }
+    std::ofstream(dev + "registers", std::ios::binary).write(registers.data(), registers.size());
+    for (int channel = 0; channel < 12; channel++) {
+      auto base = dev + "scan_elements/in_voltage" + std::to_string(channel);
+      std::ofstream(base + "_en") << "0";
+      std::ofstream(base + "_type") << "le:s16/16>>0";
+      std::ofstream(base + "_index") << channel;
+    }
+    std::ofstream(dev + "scan_elements/in_timestamp_en") << "1";
+    std::ofstream(dev + "scan_elements/in_timestamp_type") << "le:s64/64>>0";
+    std::ofstream(dev + "scan_elements/in_timestamp_index") << 12;
+    if (mkfifo((root + "/dev/" + id).c_str(), 0600) < 0) {
+      perror("mkfifo");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return root;
+}
+
+struct Device {
+  explicit Device(const std::string &root, size_t index) :
+    sysfs("iio:device" + std::to_string(index), root),
+    adc(std::make_unique<adcs::SysfsBackend>(sysfs), sysfs) {
+    adc.initialize();
+    for (auto channel : CHANNELS) {
+      adc.setChannel(channel);
+    }
+    adc.enableBuffer();
+    decoder = *adc.createScanDecoder();
+  }
+
+  adcs::IIOSysfsFilesUtil sysfs;
+  adcs::ADS114S0XB adc;
+  std::optional<adcs::ScanDecoder> decoder;
+};
+
+// Stands in for the driver: SCANS records into every FIFO, a block at a
+// time round robin, then closes them (end of stream for the readers).
+static std::thread produce(std::vector<int> fds) {
+  return std::thread([fds] {
+    std::vector<uint8_t> records(BLOCK * RECORD);
+    for (uint64_t scan = 0; scan < SCANS; scan += BLOCK) {
+      for (size_t i = 0; i < BLOCK; i++) {
+        for (size_t c = 0; c < CHANNELS.size(); c++) {
+          auto code = static_cast<int16_t>(scan + i + c);
+          memcpy(&records[i * RECORD + 2 * c], &code, sizeof code);
+        }
+        auto ts = static_cast<int64_t>(scan + i) * 250000;
+        memcpy(&records[i * RECORD + 8], &ts, sizeof ts);
+      }
+      for (auto fd : fds) {
+        for (size_t done = 0; done < records.size();) {
+          auto ret = ::write(fd, records.data() + done, records.size() - done);
+          if (ret < 0) {
+            perror("write");
+            exit(EXIT_FAILURE);
+          }
+          done += static_cast<size_t>(ret);
+        }
+      }
+    }
+    for (auto fd : fds) {
+      ::close(fd);
+    }
+  });
+}
+
+// Write ends, blocking. Opened before the sessions: a FIFO read end blocks
+// in open() until there is a writer, and a non-blocking one reads end of
+// stream. A FIFO cannot be opened for writing without a reader, so one is
+// held just for the open.
+static std::vector<int> openWriters(const std::string &root, size_t devices) {
+  std::vector<int> fds;
+  for (size_t d = 0; d < devices; d++) {
+    auto path = root + "/dev/iio:device" + std::to_string(d);
+    auto reader = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (reader < 0 || fd < 0) {
+      perror("open fifo");
+      exit(EXIT_FAILURE);
+    }
+    ::close(reader);
+    fds.push_back(fd);
+  }
+  return fds;
+}
+
+// Every record arrives in order: code of channel c is scan + c.
+static bool check(const adcs::SampleBlock &block, uint64_t firstScan) {
+  for (size_t i = 0; i < block.size; i++) {
+    if (block.timestamps[i] != static_cast<int64_t>(firstScan + i) * 250000 ||
+        block.channels[3][i] != static_cast<int16_t>(firstScan + i + 3)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static adcs::Task<void> readDevice(adcs::AsyncSession &session, const adcs::ScanDecoder &decoder,
+    uint64_t &scans, bool &ok) {
+  adcs::SampleBlock block;
+  decoder.prepare(block, BLOCK);
+  for (;;) {
+    auto n = co_await session.readRecords(decoder, block);
+    if (n <= 0) {
+      ok &= n == 0;
+      co_return;
+    }
+    ok &= check(block, scans);
+    scans += static_cast<uint64_t>(n);
+  }
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("async", argc, argv);
+  auto root = makeFakeTree();
+  std::vector<std::unique_ptr<Device>> devices;
+  for (size_t d = 0; d < MAX_DEVICES; d++) {
+    devices.push_back(std::make_unique<Device>(root, d));
+  }
+
+  for (size_t count : {1, 4, 16}) {
+    suite.runCounted("reactor/" + std::to_string(count) + " devices, one thread", 3, [&] {
+      Reactor reactor;
+      std::vector<std::unique_ptr<AsyncSession>> sessions;
+      std::vector<uint64_t> scans(count);
+      bool ok = true;
+      auto writers = openWriters(root, count);
+      for (size_t d = 0; d < count; d++) {
+        sessions.push_back(devices[d]->adc.createAsyncSession(reactor));
+        if (sessions.back()->open().first != 0) {
+          return ssize_t{-1};
+        }
+        reactor.spawn(readDevice(*sessions.back(), *devices[d]->decoder, scans[d], ok));
+      }
+      auto producer = produce(writers);
+      auto err = reactor.run();
+      producer.join();
+      ssize_t total = 0;
+      for (auto n : scans) {
+        ok &= n == SCANS;
+        total += static_cast<ssize_t>(n);
+      }
+      return ok && err == 0 ? total : -1;
+    });
+
+    // The alternative: a blocking StreamingSession on a thread per device
+    suite.runCounted("threads/" + std::to_string(count) + " devices, thread each", 3, [&] {
+      auto writers = openWriters(root, count);
+      std::vector<std::unique_ptr<StreamingSession>> sessions;
+      for (size_t d = 0; d < count; d++) {
+        sessions.push_back(std::make_unique<StreamingSession>(devices[d]->adc.createStreamingSession()));
+        if (sessions.back()->open().first != 0) {
+          return ssize_t{-1};
+        }
+      }
+      auto producer = produce(writers);
+      std::vector<uint64_t> scans(count);
+      std::vector<char> ok(count, 1);
+      std::vector<std::thread> readers;
+      for (size_t d = 0; d < count; d++) {
+        readers.emplace_back([&, d] {
+          SampleBlock block;
+          devices[d]->decoder->prepare(block, BLOCK);
+          for (ssize_t n; (n = sessions[d]->readRecords(*devices[d]->decoder, block)) > 0;) {
+            ok[d] &= check(block, scans[d]);
+            scans[d] += static_cast<uint64_t>(n);
+          }
+        });
+      }
+      for (auto &reader : readers) {
+        reader.join();
+      }
+      producer.join();
+      ssize_t total = 0;
+      for (size_t d = 0; d < count; d++) {
+        if (!ok[d] || scans[d] != SCANS) {
+          return ssize_t{-1};
+        }
+        total += static_cast<ssize_t>(scans[d]);
+      }
+      return total;
+    });
+  }
+
+  // Worker round trip: reactor -> worker thread -> eventfd -> reactor
+  Reactor reactor;
+  auto session = devices[0]->adc.createAsyncSession(reactor);
+  suite.run("register/readRegisterAsync", 5000, [&] {
+    bool ok = false;
+    reactor.spawn([](AsyncSession &s, bool &ok) -> Task<void> {
+      auto value = co_await s.readRegisterAsync(ADS114S0XBRegister::PGA);
+      ok = value.has_value();
+    }(*session, ok));
+    return reactor.run() == 0 && ok;
+  });
+
+  suite.run("check/register write, read back, burst", 1, [&] {
+    bool ok = false;
+    reactor.spawn([](AsyncSession &s, bool &ok) -> Task<void> {
+      if (!co_await s.writeRegisterAsync(ADS114S0XBRegister::PGA, 0x0a)) {
+        co_return;
+      }
+      auto value = co_await s.readRegisterAsync(ADS114S0XBRegister::PGA);
+      std::array<uint8_t, 0x12> regs;
+      auto burst = co_await s.readRegisterBlockAsync(0, regs);
+      // The fake "registers" file is separate from the attribute files
+      constexpr auto datarate = describe(ADS114S0XBRegister::DATARATE);
+      ok = value == 0x0a && burst == regs.size() && regs[datarate.address] == datarate.resetValue;
+      co_await s.writeRegisterAsync(ADS114S0XBRegister::PGA, 0x00);
+    }(*session, ok));
+    return reactor.run() == 0 && ok;
+  });
+
+  session.reset();
+  devices.clear();
+  fs::remove_all(root);
+  return suite.report();
+}
@@ -0,0 +1,209 @@
+// CalibrationCache on a simulated ADC: start-up with an empty cache, which
+// runs SYOCAL on every channel and gain at the chip's pace, against
+// start-up from the cache file, plus the cost of switching to a cached
+// calibration. Checks that the file round-trips, that a buffered scan
+// applies every channel's own offset through the driver's table, and the
+// table's rules for partial entries and the restore on disable.
+//
+//   bench/calibration-bench [--json results.json] [--filter startup/] [--dir /tmp]
+#include <filesystem>
+
+#include "BenchHarness.h"
+#include "../CalibrationCache.h"
+#include "../SimulatedBackend.h"
+
+namespace fs = std::filesystem;
+
+static const int CHANNELS = 12;
+static const adcs::Pga::Gain GAINS[] = {
+  adcs::Pga::Gain::x1, adcs::Pga::Gain::x2, adcs::Pga::Gain::x4, adcs::Pga::Gain::x8,
+};
+static const adcs::CalibrationCommand SYSTEM_OFFSET[] = {adcs::CalibrationCommand::SystemOffset};
+
+// INPMUX = channel measures AIN0 - AINchannel; AIN0 sits at 0 V, so every
+// channel sees its own offset, 1 mV per channel number (none on channel 0).
+static void setOffsets(adcs::SimulatedBackend &sim) {
+  for (int input = 1; input < CHANNELS; input++) {
+    sim.setInput(input, adcs::Waveform::dc(-0.001 * input));
+  }
+}
+
+// Every channel at every gain, as an application would at start-up.
+static bool prepareAll(adcs::CalibrationCache &cache, adcs::ADS114S0XB &adc, const std::vector<int> &channels) {
+  for (auto gain : GAINS) {
+    if (!adc.set(gain) || !cache.prepareScan(adc, channels, SYSTEM_OFFSET)) {
+      return false;
+    }
+  }
+  return adc.set(adcs::Pga::Gain::x1);
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("calibration", argc, argv);
+  std::string dir = "/tmp";
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], "--dir")) {
+      dir = argv[i + 1];
+    }
+  }
+  auto path = dir + "/calibration-bench-" + std::to_string(getpid()) + ".cal";
+
+  auto backend = std::make_unique<SimulatedBackend>(ChipVariant::ADS114S08B);
+  auto &sim = *backend;
+  ADS114S0XB adc(std::move(backend));
+  adc.initialize();
+  setOffsets(sim);
+  // 4 kSPS and CAL_SAMP = 8: 2.25 ms per calibration, 20 SPS would be 0.45 s
+  if (!adc.set(Pga::Mode::Enabled) || !adc.set(Datarate::Rate::sps4000) ||
+      !adc.set(Sys::CalibrationSamples::s8)) {
+    fprintf(stderr, "configuration failed: %s\n", strerror(adc.getLastErrno()));
+    return EXIT_FAILURE;
+  }
+  std::vector<int> channels(CHANNELS);
+  for (int c = 0; c < CHANNELS; c++) {
+    channels[c] = c;
+  }
+  const auto entries = static_cast<ssize_t>(std::size(GAINS) * CHANNELS);
+
+  suite.runCounted("startup/empty cache, SYOCAL 12ch x 4 gains", 1, [&] {
+    CalibrationCache cache;
+    if (!prepareAll(cache, adc, channels) || cache.save(path).first != 0) {
+      return ssize_t{-1};
+    }
+    return static_cast<ssize_t>(cache.calibrationsRun());
+  });
+  if (!fs::exists(path)) {
+    // Filtered out; the other cases need the file
+    CalibrationCache cache;
+    if (!prepareAll(cache, adc, channels) || cache.save(path).first != 0) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  suite.runCounted("startup/cache file, 12ch x 4 gains", 20, [&] {
+    CalibrationCache cache;
+    if (cache.load(path).first != 0 || !prepareAll(cache, adc, channels) || cache.calibrationsRun() != 0) {
+      return ssize_t{-1};
+    }
+    return static_cast<ssize_t>(cache.size());
+  });
+
+  CalibrationCache cache;
+  cache.load(path);
+  int channel = 0;
+  suite.run("switch/apply cached channel, one burst write", 10000, [&] {
+    channel = (channel + 1) % CHANNELS;
+    return cache.apply(adc, channel, SYSTEM_OFFSET).has_value();
+  });
+
+  suite.run("check/cache file round trip", 1, [&] {
+    CalibrationCache reloaded;
+    if (reloaded.load(path).first != 0 || reloaded.size() != static_cast<size_t>(entries) || reloaded.isDirty()) {
+      return false;
+    }
+    for (auto gain : GAINS) {
+      for (int c = 0; c < CHANNELS; c++) {
+        CalibrationKey key{c, gain, Datarate::Rate::sps4000};
+        if (!reloaded.find(key) || reloaded.find(key) != cache.find(key)) {
+          return false;
+        }
+      }
+    }
+    // 1 mV per channel at gain 1: 2.5 V / 32768 per code
+    auto words = reloaded.find({5, Pga::Gain::x1, Datarate::Rate::sps4000});
+    return words && words->offset == static_cast<int16_t>(std::lround(0.005 / (2.5 / 32768)));
+  });
+
+  // Without the table only the first channel would be corrected
+  suite.run("check/scan applies each channel's offset", 1, [&] {
+    if (!adc.set(Pga::Gain::x4) || !cache.prepareScan(adc, channels, SYSTEM_OFFSET)) {
+      return false;
+    }
+    for (auto c : channels) {
+      adc.setChannel(c);
+    }
+    sim.setPacing(SimulatedBackend::Pacing::FreeRunning);
+    auto source = adc.createSampleSource(64);
+    if (!source) {
+      return false;
+    }
+    SampleBlock block;
+    source->prepare(block, 64);
+    if (source->read(block) <= 0) {
+      return false;
+    }
+    for (size_t c = 0; c < block.channelCount(); c++) {
+      for (size_t i = 0; i < block.size; i++) {
+        if (std::abs(block.channels[c][i]) > 1) {
+          fprintf(stderr, "channel %d reads %d after calibration\n", block.channelIds[c], block.channels[c][i]);
+          return false;
+        }
+      }
+    }
+    source.reset();
+    sim.setPacing(SimulatedBackend::Pacing::RealTime);
+    return adc.set(Pga::Gain::x1);
+  });
+
+  // The driver's table rules: whole entries only, the reset words remove
+  // an entry, channels without one get OFCAL/FSCAL from before the enable,
+  // which come back on disable, also after a single-channel scan
+  suite.run("check/partial entries, restore on disable", 1, [&] {
+    const uint8_t half[3] = {};
+    std::vector<uint8_t> resetTable;
+    for (int c = 0; c < CHANNELS; c++) {
+      auto regs = CalibrationWords{}.registers();
+      resetTable.insert(resetTable.end(), regs.begin(), regs.end());
+    }
+    auto before = CalibrationWords{100, 0x4000}.registers();
+    auto entry5 = CalibrationWords{static_cast<int16_t>(std::lround(0.005 / (2.5 / 32768))), 0x4000}.registers();
+    if (adc.writeCalibrationTable(0, half) || adc.getLastErrno() != EINVAL ||
+        adc.writeCalibrationTable(0, resetTable) != resetTable.size() ||
+        adc.writeCalibrationTable(5, entry5) != entry5.size() ||
+        adc.writeRegisterBlock(describe(ADS114S0XBRegister::OFCAL0).address, before) != before.size()) {
+      return false;
+    }
+    // First code of each channel of a scan, then OFCAL0..FSCAL1 after it
+    auto scan = [&](std::vector<int> scanChannels, std::vector<int16_t> &codes) {
+      for (auto c : channels) {
+        adc.resetChannel(c);
+      }
+      for (auto c : scanChannels) {
+        adc.setChannel(c);
+      }
+      sim.setPacing(SimulatedBackend::Pacing::FreeRunning);
+      auto source = adc.createSampleSource(1);
+      SampleBlock block;
+      if (!source) {
+        return false;
+      }
+      source->prepare(block, 1);
+      if (source->read(block) != 1) {
+        return false;
+      }
+      codes.clear();
+      for (size_t c = 0; c < block.channelCount(); c++) {
+        codes.push_back(block.channels[c][0]);
+      }
+      source.reset();
+      sim.setPacing(SimulatedBackend::Pacing::RealTime);
+      std::array<uint8_t, CALIBRATION_ENTRY_SIZE> regs;
+      return adc.readRegisterBlock(describe(ADS114S0XBRegister::OFCAL0).address, regs) == regs.size() &&
+        regs == before;
+    };
+    // 3 mV on channel 3, less the 100 codes of the words before the enable
+    std::vector<int16_t> codes;
+    auto expected3 = std::lround(0.003 / (2.5 / 32768)) - 100;
+    if (!scan({3, 5}, codes) || std::abs(codes[0] - expected3) > 1 || std::abs(codes[1]) > 1 ||
+        !adc.writeRegisterValue(ADS114S0XBRegister::INPMUX, 5) || !scan({5}, codes) || std::abs(codes[0]) > 1) {
+      return false;
+    }
+    auto reset = CalibrationWords{}.registers();
+    return adc.writeCalibrationTable(0, resetTable) == resetTable.size() &&
+      adc.writeRegisterBlock(describe(ADS114S0XBRegister::OFCAL0).address, reset) == reset.size();
+  });
+
+  fs::remove(path);
+  return suite.report();
+}
@@ -0,0 +1,203 @@
+// Capture files: what append() costs the acquisition thread, how long the
+// background writer needs to drain at close, and how fast a reader opens,
+// seeks and scans a mapped file. Ends with a round trip check of every
+// sample, across a mid-capture config change and a file missing its index.
+//
+//   bench/capture-bench [--json results.json] [--filter read/] [--dir /tmp]
+#include <cinttypes>
+#include <filesystem>
+
+#include "BenchHarness.h"
+#include "../CaptureFile.h"
+
+namespace fs = std::filesystem;
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+static const std::vector<int> CHANNELS_AFTER = {1, 5};
+static const size_t BLOCK = 256;
+static const uint64_t BLOCKS = 8192; // 2 Mscans, 20 MB with timestamps
+static const int64_t PERIOD_NS = 250000;
+
+static int16_t codeAt(uint64_t scan, size_t c) {
+  return static_cast<int16_t>(scan * 7 + c * 1000);
+}
+
+static void fill(adcs::SampleBlock &block, uint64_t firstScan) {
+  for (size_t i = 0; i < block.capacity(); i++) {
+    block.timestamps[i] = static_cast<int64_t>(firstScan + i) * PERIOD_NS;
+    for (size_t c = 0; c < block.channelCount(); c++) {
+      block.channels[c][i] = codeAt(firstScan + i, c);
+    }
+  }
+  block.size = block.capacity();
+}
+
+static adcs::CaptureConfig config(const std::vector<int> &channels, uint8_t pga) {
+  std::array<uint8_t, adcs::CAPTURE_REGISTERS> regs{};
+  for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+    if (reg.address < regs.size()) {
+      regs[reg.address] = reg.resetValue;
+    }
+  }
+  regs[adcs::describe(adcs::ADS114S0XBRegister::PGA).address] = pga;
+  return adcs::CaptureConfig::make(channels, regs);
+}
+
+// Every scan of the file matches what fill() wrote, in order.
+static bool verify(const adcs::CaptureReader &reader, uint64_t scansBefore, uint64_t scansAfter) {
+  uint64_t scan = 0;
+  for (size_t i = 0; i < reader.chunkCount(); i++) {
+    auto chunk = reader.chunk(i);
+    const auto &cfg = reader.configs()[chunk.config];
+    if (chunk.channels != cfg.channelCount || (scan < scansBefore) != (chunk.config == 0)) {
+      return false;
+    }
+    for (size_t s = 0; s < chunk.scans; s++, scan++) {
+      if (chunk.timestamps()[s] != static_cast<int64_t>(scan) * PERIOD_NS) {
+        return false;
+      }
+      for (size_t c = 0; c < chunk.channels; c++) {
+        if (chunk.column(c)[s] != codeAt(scan, c)) {
+          return false;
+        }
+      }
+    }
+  }
+  return scan == scansBefore + scansAfter && reader.configs().size() == 2 &&
+    reader.configs()[1].reg(adcs::ADS114S0XBRegister::PGA) == 0x0a;
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("capture", argc, argv);
+  std::string dir = "/tmp";
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], "--dir")) {
+      dir = argv[i + 1];
+    }
+  }
+  auto path = dir + "/capture-bench-" + std::to_string(getpid()) + ".cap";
+  auto truncated = path + ".noindex";
+
+  // Write: BLOCKS blocks, a config change, BLOCKS / 4 more on fewer channels
+  CaptureWriterOptions options;
+  options.buffers = 64;
+  CaptureWriter writer(options);
+  if (auto status = writer.open(path, config(CHANNELS, 0x00)); status.first != 0) {
+    fprintf(stderr, "%s: %s\n", status.second.c_str(), strerror(status.first));
+    return EXIT_FAILURE;
+  }
+  SampleBlock block;
+  block.reset(CHANNELS, BLOCK);
+  uint64_t scan = 0;
+  fill(block, scan); // the warm-up call of run() appends a block as well
+  suite.run("write/append 256 scans", BLOCKS - 1, [&] {
+    fill(block, scan);
+    scan += block.size;
+    return writer.append(block);
+  }, BLOCK * CHANNELS.size());
+  auto scansBefore = scan;
+  writer.writeConfig(config(CHANNELS_AFTER, 0x0a));
+  block.reset(CHANNELS_AFTER, BLOCK);
+  for (uint64_t i = 0; i < BLOCKS / 4; i++) {
+    fill(block, scan);
+    scan += block.size;
+    writer.append(block);
+  }
+  auto scansAfter = scan - scansBefore;
+  auto dropped = writer.getDroppedScans();
+  suite.runCounted("write/close (drain, index, fdatasync)", 1, [&] {
+    return writer.close().first == 0 ? 1 : -1;
+  });
+  writer.close(); // when filtered out above
+  printf("%" PRIu64 " scans dropped by the writer, %" PRIu64 " bytes written\n", dropped, writer.getBytesWritten());
+
+  // The same file as left behind by a capture that was killed
+  fs::copy_file(path, truncated, fs::copy_options::overwrite_existing);
+  {
+    CaptureReader reader;
+    reader.open(path);
+    if (reader.chunkCount() > 0) {
+      auto last = reader.chunk(reader.chunkCount() - 1);
+      auto end = reinterpret_cast<const uint8_t *>(last.columnData + last.scans * last.channels);
+      auto offset = end - reinterpret_cast<const uint8_t *>(&reader.header());
+      fs::resize_file(truncated, (static_cast<size_t>(offset) + CAPTURE_ALIGNMENT - 1) & ~(CAPTURE_ALIGNMENT - 1));
+    }
+  }
+
+  CaptureReader reader;
+  suite.run("read/open (index)", 1000, [&] {
+    return reader.open(path).first == 0 && reader.hasIndex();
+  });
+  suite.run("read/open (rebuilt index)", 1000, [&] {
+    return reader.open(truncated).first == 0 && !reader.hasIndex();
+  });
+
+  reader.open(path);
+  uint64_t rng = 1;
+  auto duration = static_cast<int64_t>(scansBefore + scansAfter - 1) * PERIOD_NS;
+  suite.run("read/seek to random time", 1000000, [&] {
+    rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+    auto t = static_cast<int64_t>((rng >> 11) % static_cast<uint64_t>(duration));
+    auto i = reader.seek(t);
+    if (i == reader.chunkCount()) {
+      fprintf(stderr, "seek %" PRId64 " past the end\n", t);
+      return false;
+    }
+    auto chunk = reader.chunk(i);
+    auto s = chunk.lowerBound(t);
+    return s < chunk.scans && chunk.timestamps()[s] >= t;
+  });
+  suite.runCounted("read/scan every sample", 10, [&] {
+    int64_t sum = 0;
+    ssize_t samples = 0;
+    for (size_t i = 0; i < reader.chunkCount(); i++) {
+      auto chunk = reader.chunk(i);
+      for (size_t c = 0; c < chunk.channels; c++) {
+        for (auto code : chunk.column(c)) {
+          sum += code;
+        }
+      }
+      samples += static_cast<ssize_t>(chunk.scans * chunk.channels);
+    }
+    return sum == 0x7fffffffffffffff ? -1 : samples; // keeps sum alive
+  });
+
+  suite.run("check/round trip (index)", 1, [&] {
+    return reader.open(path).first == 0 && verify(reader, scansBefore, scansAfter);
+  });
+  suite.run("check/round trip (rebuilt index)", 1, [&] {
+    return reader.open(truncated).first == 0 && verify(reader, scansBefore, scansAfter);
+  });
+
+  // Open trusts the index; a damaged DATA chunk shows up when it is read
+  suite.run("check/damaged chunk reads as empty", 1, [&] {
+    fs::copy_file(path, truncated, fs::copy_options::overwrite_existing);
+    FILE *f = fopen(truncated.c_str(), "r+b");
+    uint32_t magic = 0;
+    bool written = f && fseek(f, CAPTURE_ALIGNMENT, SEEK_SET) == 0 && fwrite(&magic, sizeof magic, 1, f) == 1;
+    if (f) {
+      fclose(f);
+    }
+    return written && reader.open(truncated).first == 0 && reader.hasIndex() && reader.chunkCount() > 1 &&
+      reader.chunk(0).scans == 0 && reader.chunk(0).timestamps().empty() && reader.chunk(1).scans > 0;
+  });
+
+  // channels() would read past channelIds
+  suite.run("check/reject config with too many channels", 1, [&] {
+    fs::copy_file(path, truncated, fs::copy_options::overwrite_existing);
+    FILE *f = fopen(truncated.c_str(), "r+b");
+    uint8_t channelCount = MAX_SCAN_CHANNELS + 1;
+    auto offset = offsetof(CaptureFileHeader, config) + offsetof(CaptureConfig, channelCount);
+    bool written = f && fseek(f, static_cast<long>(offset), SEEK_SET) == 0 && fwrite(&channelCount, 1, 1, f) == 1;
+    if (f) {
+      fclose(f);
+    }
+    return written && reader.open(truncated).first == EINVAL && !reader.isOpen();
+  });
+
+  reader.close();
+  fs::remove(path);
+  fs::remove(truncated);
+  return suite.report();
+}
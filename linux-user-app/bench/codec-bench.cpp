@@ -0,0 +1,137 @@
+// SampleCodec: encode and decode speed and compression ratio on a few
+// kinds of 16-bit sample streams, plus a randomised round trip check and
+// a check that damaged streams are rejected rather than overrun.
+//
+//   bench/codec-bench [--json results.json] [--filter decode/]
+#include <cmath>
+#include <random>
+
+#include "BenchHarness.h"
+#include "../SampleCodec.h"
+
+static const size_t SAMPLES = 1 << 20;
+static const double LSB = 2.5 / 32768; // gain 1, internal reference
+
+struct Dataset {
+  const char *name;
+  std::vector<int16_t> samples;
+};
+
+static int16_t clampCode(double code) {
+  return static_cast<int16_t>(std::lround(std::clamp(code, -32768.0, 32767.0)));
+}
+
+static std::vector<Dataset> makeDatasets() {
+  std::mt19937 rng(1);
+  std::vector<Dataset> sets;
+  // 1 V with 5 mV of 50 Hz pickup at 4 kSPS and 2 LSB of noise
+  std::normal_distribution<double> noise(0.0, 2.0);
+  Dataset sensor{"sensor 1 V + 50 Hz + noise", {}};
+  for (size_t i = 0; i < SAMPLES; i++) {
+    sensor.samples.push_back(clampCode((1.0 + 0.005 * std::sin(2 * M_PI * 50 * i / 4000.0)) / LSB + noise(rng)));
+  }
+  sets.push_back(std::move(sensor));
+  // Thermocouple-like drift, quiet
+  std::normal_distribution<double> quiet(0.0, 0.5);
+  Dataset drift{"slow drift", {}};
+  for (size_t i = 0; i < SAMPLES; i++) {
+    drift.samples.push_back(clampCode(1000.0 + 3000.0 * std::sin(2 * M_PI * i / SAMPLES) + quiet(rng)));
+  }
+  sets.push_back(std::move(drift));
+  // Incompressible: uniform over the full scale
+  std::uniform_int_distribution<int> uniform(-32768, 32767);
+  Dataset white{"white noise full scale", {}};
+  for (size_t i = 0; i < SAMPLES; i++) {
+    white.samples.push_back(static_cast<int16_t>(uniform(rng)));
+  }
+  sets.push_back(std::move(white));
+  return sets;
+}
+
+// Random lengths and shapes, including the widest residuals possible.
+static std::vector<int16_t> randomStream(std::mt19937 &rng) {
+  std::vector<int16_t> samples(std::uniform_int_distribution<size_t>(0, 2000)(rng));
+  auto shape = rng() % 5;
+  int16_t value = static_cast<int16_t>(rng());
+  for (size_t i = 0; i < samples.size(); i++) {
+    switch (shape) {
+    case 0: samples[i] = static_cast<int16_t>(rng()); break;
+    case 1: samples[i] = i % 2 ? INT16_MAX : INT16_MIN; break;
+    case 2: samples[i] = value; break;
+    case 3: value = static_cast<int16_t>(value + static_cast<int>(rng() % 7) - 3); samples[i] = value; break;
+    default: samples[i] = static_cast<int16_t>(i * 37); break;
+    }
+  }
+  return samples;
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("codec", argc, argv);
+  auto datasets = makeDatasets();
+  std::vector<uint8_t> encoded(SampleCodec::maxEncodedSize(SAMPLES));
+  std::vector<int16_t> decoded(SAMPLES);
+
+  for (const auto &set : datasets) {
+    size_t bytes = 0;
+    suite.run(std::string("encode/") + set.name, 50, [&] {
+      bytes = SampleCodec::encode(set.samples, encoded).value_or(0);
+      return bytes > 0;
+    }, SAMPLES);
+    bytes = SampleCodec::encode(set.samples, encoded).value_or(0);
+    const auto &result = suite.run(std::string("decode/") + set.name, 200, [&] {
+      return SampleCodec::decode({encoded.data(), bytes}, decoded) == SAMPLES;
+    }, SAMPLES);
+    bool same = SampleCodec::decode({encoded.data(), bytes}, decoded) == SAMPLES && decoded == set.samples;
+    if (!suite.enabled(std::string("decode/") + set.name)) {
+      continue;
+    }
+    printf("%-28s ratio %5.2fx  decode %6.2f GB/s%s\n", set.name,
+      static_cast<double>(SAMPLES * sizeof(int16_t)) / bytes,
+      result.itemsPerSecond * sizeof(int16_t) / 1e9, same ? "" : "  MISMATCH");
+    if (!same) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::mt19937 rng(2);
+  suite.run("check/round trip, random streams", 20000, [&] {
+    auto samples = randomStream(rng);
+    std::vector<uint8_t> out(SampleCodec::maxEncodedSize(samples.size()));
+    auto bytes = SampleCodec::encode(samples, out);
+    std::vector<int16_t> back(samples.size());
+    if (!bytes || SampleCodec::decode({out.data(), *bytes}, back) != samples.size() || back != samples) {
+      return false;
+    }
+    // Random access: every block on its own
+    auto offsets = SampleCodec::blockOffsets({out.data(), *bytes});
+    if (!offsets || offsets->size() != (samples.size() + 255) / 256) {
+      return false;
+    }
+    for (size_t k = 0; k < offsets->size(); k++) {
+      int16_t block[SampleCodec::BLOCK_SAMPLES];
+      auto n = SampleCodec::decodeBlock({out.data() + (*offsets)[k], *bytes - (*offsets)[k]}, block);
+      if (!n || !std::equal(block, block + *n, samples.begin() + k * SampleCodec::BLOCK_SAMPLES)) {
+        return false;
+      }
+    }
+    return true;
+  });
+  suite.run("check/damaged streams", 20000, [&] {
+    auto samples = randomStream(rng);
+    std::vector<uint8_t> out(SampleCodec::maxEncodedSize(samples.size()));
+    auto bytes = SampleCodec::encode(samples, out).value_or(0);
+    if (bytes == 0) {
+      return true;
+    }
+    out.resize(bytes - rng() % std::min<size_t>(bytes, 16)); // truncated
+    for (int i = 0; i < 4; i++) {
+      out[rng() % out.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+    }
+    std::vector<int16_t> back(samples.size());
+    auto n = SampleCodec::decode(out, back);
+    return !n || *n <= back.size();
+  });
+
+  return suite.report();
+}
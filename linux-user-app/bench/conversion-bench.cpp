@@ -0,0 +1,94 @@
+// Throughput of the raw code to volts conversion: the scalar fallback
+// against each SIMD level this CPU supports, checked against each other.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "../VoltageConverter.h"
+
+// A block that stays in L2, so the kernels rather than DRAM are measured
+static const size_t SAMPLES = 1 << 14;
+static const int ROUNDS = 4000;
+
+static const char *levelName(adcs::SimdLevel level) {
+  switch (level) {
+  case adcs::SimdLevel::Sse41: return "sse4.1";
+  case adcs::SimdLevel::Avx2: return "avx2";
+  case adcs::SimdLevel::Neon: return "neon";
+  default: return "scalar";
+  }
+}
+
+template <typename F>
+static double samplesPerNs(F &&convert) {
+  convert(); // warm up caches and the dispatcher
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; r++) {
+    convert();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(SAMPLES) * ROUNDS / std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+template <typename T>
+static bool run(const char *type, const std::vector<int16_t> &codes, const adcs::ConversionParams &params) {
+  using namespace adcs;
+  std::vector<T> reference(SAMPLES), out(SAMPLES);
+  detail::convertScalar(codes.data(), reference.data(), SAMPLES,
+      static_cast<T>(params.scale), static_cast<T>(params.offset));
+
+  bool ok = true;
+  double scalar = 0;
+  for (auto level : {SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2, SimdLevel::Neon}) {
+    if (level != SimdLevel::Scalar && level > detectSimdLevel()) {
+      continue;
+    }
+#ifndef __aarch64__
+    if (level == SimdLevel::Neon) {
+      continue;
+    }
+#endif
+    auto rate = samplesPerNs([&] {
+      convertCodes<T>(codes, out, params, level);
+    });
+    if (level == SimdLevel::Scalar) {
+      scalar = rate;
+    }
+    // One LSB at gain 16 is ~4.8 uV, the paths must agree far below that
+    T worst = 0;
+    for (size_t i = 0; i < SAMPLES; i++) {
+      worst = std::max(worst, static_cast<T>(std::fabs(out[i] - reference[i])));
+    }
+    ok = ok && worst <= static_cast<T>(params.scale * 1e-3);
+    printf("%-6s %-8s              %8.3f samples/ns  (%.2fx scalar, max diff %g V)\n",
+        type, levelName(level), rate, rate / scalar, static_cast<double>(worst));
+  }
+  return ok;
+}
+
+int main() {
+  using namespace adcs;
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> dist(INT16_MIN, INT16_MAX);
+  std::vector<int16_t> codes(SAMPLES);
+  for (size_t i = 0; i < SAMPLES; i++) {
+    codes[i] = static_cast<int16_t>(dist(rng));
+  }
+
+  // PGA enabled at x16 on the internal reference
+  constexpr auto pga = RegisterValue<ADS114S0XBRegister::PGA>{}
+    .with(Pga::Mode::Enabled).with(Pga::Gain::x16);
+  constexpr auto ref = RegisterValue<ADS114S0XBRegister::REF>{}.with(Ref::Select::Internal);
+  auto params = ConversionParams::fromRegisters(pga, ref);
+
+  printf("best level: %s, %zu samples x %d rounds\n", levelName(detectSimdLevel()), SAMPLES, ROUNDS);
+  bool ok = run<float>("float", codes, params);
+  ok = run<double>("double", codes, params) && ok;
+  if (!ok) {
+    fprintf(stderr, "SIMD output differs from the scalar reference\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
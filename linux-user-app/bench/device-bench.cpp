@@ -0,0 +1,153 @@
+// DeviceManager on simulated ADCs: aggregate reader throughput for 1..8
+// devices, each engine pinned to its own CPU where there are enough, the
+// cost of the k-way timestamp merge on top, and a check that the merged
+// stream is ordered and complete when devices end at different times.
+// Scaling is only near-linear while devices <= cores.
+//
+//   bench/device-bench [--json results.json] [--filter merged/]
+#include <cinttypes>
+#include <thread>
+
+#include "BenchHarness.h"
+#include "../DeviceManager.h"
+#include "../SimulatedBackend.h"
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+static const double RATE = 1e6;
+
+static void addDevices(adcs::DeviceManager &manager, size_t count, const std::vector<uint64_t> &limits) {
+  using namespace adcs;
+  for (size_t i = 0; i < count; i++) {
+    auto chip = i % 2 ? ChipVariant::ADS114S06B : ChipVariant::ADS114S08B;
+    auto backend = std::make_unique<SimulatedBackend>(chip);
+    auto &sim = *backend;
+    auto adc = std::make_unique<ADS114S0XB>(std::move(backend));
+    adc->initialize();
+    for (int input = 0; input < 6; input++) {
+      sim.setInput(input, Waveform::sine(0.5, 50.0 + input + 10 * i));
+    }
+    sim.setPacing(SimulatedBackend::Pacing::FreeRunning);
+    sim.setSampleRate(RATE);
+    sim.setScanLimit(limits[i % limits.size()]);
+    for (auto channel : CHANNELS) {
+      adc->setChannel(channel);
+    }
+    manager.addDevice(std::move(adc), {"sim" + std::to_string(i),
+      chip == ChipVariant::ADS114S06B ? "ads114s06b" : "ads114s08b", chip});
+  }
+}
+
+static adcs::DeviceManagerOptions options(size_t devices) {
+  adcs::DeviceManagerOptions options;
+  auto cores = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < devices; i++) {
+    options.cpus.push_back(static_cast<int>(i % cores));
+  }
+  return options;
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("device", argc, argv);
+  const uint64_t scans = 1 << 20;
+  printf("%u cores, %zu channels per device, free running\n", std::thread::hardware_concurrency(), CHANNELS.size());
+
+  for (size_t devices : {1, 2, 4, 8}) {
+    // Every device's ring drained on its own, no ordering across devices
+    auto name = "readers/" + std::to_string(devices) + " devices";
+    uint64_t lost = 0;
+    suite.runCounted(name, 3, [&] {
+      DeviceManager manager;
+      addDevices(manager, devices, {scans});
+      if (manager.start(options(devices)).first != 0) {
+        return ssize_t{-1};
+      }
+      ScanRecord records[256];
+      ssize_t total = 0;
+      for (bool running = true; running;) {
+        running = false;
+        size_t popped = 0;
+        for (size_t i = 0; i < devices; i++) {
+          auto &engine = manager.engine(i);
+          popped += engine.popBatch(records);
+          running |= engine.isRunning() || engine.queued() > 0;
+        }
+        if (popped == 0) {
+          std::this_thread::yield();
+        }
+        total += static_cast<ssize_t>(popped);
+      }
+      for (size_t i = 0; i < devices; i++) {
+        lost += manager.engine(i).getStats().overruns;
+      }
+      return total;
+    });
+
+    auto merged = "merged/" + std::to_string(devices) + " devices";
+    suite.runCounted(merged, 3, [&] {
+      DeviceManager manager;
+      addDevices(manager, devices, {scans});
+      if (manager.start(options(devices)).first != 0) {
+        return ssize_t{-1};
+      }
+      DeviceScan out[256];
+      ssize_t total = 0;
+      while (manager.isRunning()) {
+        auto n = manager.popMerged(out);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        total += static_cast<ssize_t>(n);
+      }
+      for (size_t i = 0; i < devices; i++) {
+        lost += manager.engine(i).getStats().overruns;
+      }
+      return total;
+    });
+    if (suite.enabled(name) || suite.enabled(merged)) {
+      printf("%zu devices: %" PRIu64 " scans lost to ring overruns\n", devices, lost);
+    }
+  }
+
+  // Devices of different lengths: ordered, and every scan a reader queued
+  // comes out exactly once
+  suite.run("check/merged order and completeness", 1, [&] {
+    DeviceManager manager;
+    std::vector<uint64_t> limits = {300000, 100000, 250000, 1};
+    addDevices(manager, limits.size(), limits);
+    auto opts = options(limits.size());
+    opts.ringCapacity = 1 << 20; // nothing lost, whatever the scheduling
+    if (manager.start(opts).first != 0) {
+      return false;
+    }
+    std::vector<uint64_t> counts(limits.size());
+    std::vector<int64_t> previous(limits.size(), INT64_MIN);
+    int64_t last = INT64_MIN;
+    DeviceScan out[100];
+    while (manager.isRunning()) {
+      auto n = manager.popMerged(out);
+      for (size_t i = 0; i < n; i++) {
+        auto &scan = out[i];
+        if (scan.scan.timestamp < last || scan.scan.timestamp <= previous[scan.device]) {
+          fprintf(stderr, "out of order at device %zu\n", scan.device);
+          return false;
+        }
+        last = scan.scan.timestamp;
+        previous[scan.device] = last;
+        counts[scan.device]++;
+      }
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+    }
+    for (size_t i = 0; i < limits.size(); i++) {
+      if (counts[i] != limits[i] || manager.engine(i).getStats().overruns != 0) {
+        fprintf(stderr, "device %zu: %" PRIu64 " of %" PRIu64 " scans\n", i, counts[i], limits[i]);
+        return false;
+      }
+    }
+    return manager.info(1).chip == ChipVariant::ADS114S06B && manager.channelIds(0) == CHANNELS;
+  });
+
+  return suite.report();
+}
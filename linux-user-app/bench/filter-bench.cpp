@@ -0,0 +1,194 @@
+// Per-channel throughput of the filter stages on converted blocks, and a
+// check that none of them allocates once set up.
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "../FilterPipeline.h"
+
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+static const size_t CHANNELS = 4;
+static const size_t BLOCK = 1024;
+static const int ROUNDS = 4000;
+static const double RATE = 4000.0;
+
+static void fill(adcs::VoltageBlock &block, std::mt19937 &rng) {
+  std::normal_distribution<float> noise(0.0f, 1e-3f);
+  for (size_t c = 0; c < block.channelCount(); c++) {
+    for (size_t i = 0; i < block.capacity(); i++) {
+      block.channels[c][i] = 1.0f + 0.1f * std::sin(2 * M_PI * 50.0 * i / RATE) + noise(rng);
+    }
+  }
+  for (size_t i = 0; i < block.capacity(); i++) {
+    block.timestamps[i] = static_cast<int64_t>(i) * 250000;
+  }
+  block.size = block.capacity();
+}
+
+// Returns Msamples/s per channel; fails the run if process() allocates.
+static double measure(const char *name, adcs::FilterPipeline &pipeline, const adcs::VoltageBlock &input) {
+  auto block = input;
+  pipeline.setup(block);
+  auto before = allocations.load();
+  std::chrono::nanoseconds elapsed{0};
+  for (int r = 0; r < ROUNDS; r++) {
+    // Restore the input outside the timed region; the stages work in place
+    std::copy(input.channels.begin(), input.channels.end(), block.channels.begin());
+    std::copy(input.timestamps.begin(), input.timestamps.end(), block.timestamps.begin());
+    block.size = input.size;
+    auto start = std::chrono::steady_clock::now();
+    pipeline.process(block);
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+  auto allocated = allocations.load() - before;
+  double rate = static_cast<double>(BLOCK) * ROUNDS / std::chrono::duration<double>(elapsed).count() / 1e6;
+  printf("%-34s %9.1f Msamples/s/channel  %zu allocations\n", name, rate, allocated);
+  if (allocated != 0) {
+    fprintf(stderr, "%s allocated while streaming\n", name);
+    exit(EXIT_FAILURE);
+  }
+  return rate;
+}
+
+// A CIC of order 1 is a boxcar, and a DC input must come out unchanged.
+static bool check(const adcs::VoltageBlock &input) {
+  using namespace adcs;
+  FilterPipeline boxcar, cic;
+  boxcar.add<BoxcarDecimator>(8);
+  cic.add<CicDecimator>(8, 1);
+  auto a = input, b = input;
+  boxcar.setup(a);
+  cic.setup(b);
+  // Odd block sizes exercise the decimation phase across blocks
+  for (size_t offset = 0, chunk = 13; offset < input.size; offset += chunk) {
+    VoltageBlock pa = input, pb = input;
+    size_t n = std::min(chunk, input.size - offset);
+    for (size_t c = 0; c < input.channelCount(); c++) {
+      std::copy_n(input.channels[c].begin() + offset, n, pa.channels[c].begin());
+      std::copy_n(input.channels[c].begin() + offset, n, pb.channels[c].begin());
+    }
+    std::copy_n(input.timestamps.begin() + offset, n, pa.timestamps.begin());
+    std::copy_n(input.timestamps.begin() + offset, n, pb.timestamps.begin());
+    pa.size = pb.size = n;
+    boxcar.process(pa);
+    cic.process(pb);
+    if (pa.size != pb.size) {
+      return false;
+    }
+    for (size_t i = 0; i < pa.size; i++) {
+      if (std::fabs(pa.channels[0][i] - pb.channels[0][i]) > 1e-5f || pa.timestamps[i] != pb.timestamps[i]) {
+        return false;
+      }
+    }
+  }
+
+  // Blocks beyond setup()'s maxBlock go through in slices, not truncated
+  FilterPipeline sized, small;
+  sized.add<CicDecimator>(8, 3);
+  small.add<CicDecimator>(8, 3);
+  sized.setup(input.channelCount(), input.size);
+  small.setup(input.channelCount(), 100);
+  for (int r = 0; r < 2; r++) {
+    auto pa = input, pb = input;
+    sized.process(pa);
+    small.process(pb);
+    if (pa.size != input.size / 8 || pb.size != pa.size || pb.timestamps != pa.timestamps) {
+      return false;
+    }
+    for (size_t c = 0; c < pa.channelCount(); c++) {
+      for (size_t i = 0; i < pa.size; i++) {
+        if (std::fabs(pa.channels[c][i] - pb.channels[c][i]) > 1e-5f) {
+          return false;
+        }
+      }
+    }
+  }
+
+  VoltageBlock dc = input;
+  for (auto &column : dc.channels) {
+    std::fill(column.begin(), column.end(), 1.0f);
+  }
+  FilterPipeline smooth;
+  smooth.add<CicDecimator>(4, 3);
+  smooth.add<BiquadCascade>(std::vector{Biquad::notch(50.0, RATE / 4), Biquad::lowpass(100.0, RATE / 4)});
+  smooth.setup(dc);
+  for (int r = 0; r < 4; r++) {
+    auto block = dc;
+    smooth.process(block);
+    if (r == 3 && std::fabs(block.channels[0][block.size - 1] - 1.0f) > 1e-3f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  using namespace adcs;
+  std::mt19937 rng(1);
+  VoltageBlock input;
+  input.reset({0, 1, 2, 3}, BLOCK);
+  fill(input, rng);
+
+  if (!check(input)) {
+    fprintf(stderr, "filter stages disagree\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("%zu channels, %zu-scan blocks at %.0f SPS\n", CHANNELS, BLOCK, RATE);
+  {
+    FilterPipeline p;
+    p.add<BoxcarDecimator>(16);
+    measure("boxcar /16", p, input);
+  }
+  {
+    FilterPipeline p;
+    p.add<CicDecimator>(16, 3);
+    measure("CIC order 3 /16 (46 taps)", p, input);
+  }
+  {
+    FilterPipeline p;
+    std::vector<float> taps(64, 1.0f / 64);
+    p.add<FirDecimator>(taps, 1);
+    measure("FIR 64 taps", p, input);
+  }
+  {
+    FilterPipeline p;
+    std::vector<float> taps(64, 1.0f / 64);
+    p.add<FirDecimator>(taps, 8);
+    measure("FIR 64 taps /8", p, input);
+  }
+  {
+    FilterPipeline p;
+    p.add<BiquadCascade>(std::vector{Biquad::notch(50.0, RATE), Biquad::lowpass(200.0, RATE)});
+    measure("biquad x2 (50 Hz notch + lowpass)", p, input);
+  }
+  {
+    FilterPipeline p;
+    p.add<BiquadCascade>(std::vector{Biquad::notch(50.0, RATE)});
+    p.add<CicDecimator>(8, 3);
+    p.add<FirDecimator>(std::vector<float>(16, 1.0f / 16), 2);
+    measure("notch -> CIC /8 -> FIR /2", p, input);
+  }
+  return EXIT_SUCCESS;
+}
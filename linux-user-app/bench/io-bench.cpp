@@ -0,0 +1,215 @@
+// Control and data path costs of ADS114S0XB against a fake sysfs/dev tree
+// (SysfsBackend), from single attribute accesses to a streaming read loop.
+// The hot path records into the device's Metrics; bench/io-bench-nometrics
+// is the same program built with ADS114S0XB_NO_METRICS, so the two tables
+// side by side show what the instrumentation costs.
+//
+//   bench/io-bench [--json results.json] [--filter stream/] [--prometheus io.prom]
+#include <filesystem>
+#include <fstream>
+
+#include "BenchHarness.h"
+#include "../ADS114S0XB.h"
+#include "../AcquisitionEngine.h"
+#include "../SysfsBackend.h"
+
+namespace fs = std::filesystem;
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+static const uint64_t CONTROL_OPS = 20000;
+static const uint64_t STREAM_SCANS = 1 << 20;
+static const size_t STREAM_BLOCK = 256;
+
+// The driver's sysfs layout for an ADS114S08B with every register as an
+// attribute file. /dev/iio:device0 is a regular file holding STREAM_SCANS
+// records of CHANNELS plus the timestamp (16 bytes each).
+static std::string makeFakeTree() {
+  char tmpl[] = "/tmp/ads114s0xb-bench-XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    perror("mkdtemp");
+    exit(EXIT_FAILURE);
+  }
+  std::string root(tmpl);
+  auto dev = root + "/sys/bus/iio/devices/iio:device0/";
+  fs::create_directories(dev + "scan_elements");
+  fs::create_directories(dev + "buffer");
+  fs::create_directories(root + "/sys/bus/iio/devices/trigger0");
+  fs::create_directories(root + "/dev");
+  std::ofstream(root + "/sys/bus/iio/devices/trigger0/trigger_now") << "0";
+  std::ofstream(dev + "buffer/enable") << "0";
+  std::ofstream(dev + "buffer/length") << "128";
+  std::ofstream(dev + "buffer/watermark") << "1";
+  for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+    std::ofstream(dev + std::string(reg.name)) << static_cast<unsigned>(reg.resetValue) << "\n";
+  }
+  for (int channel = 0; channel < 12; channel++) {
+    auto base = dev + "scan_elements/in_voltage" + std::to_string(channel);
+    std::ofstream(base + "_en") << "0";
+    std::ofstream(base + "_type") << "le:s16/16>>0";
+    std::ofstream(base + "_index") << channel;
+  }
+  std::ofstream(dev + "scan_elements/in_timestamp_en") << "1";
+  std::ofstream(dev + "scan_elements/in_timestamp_type") << "le:s64/64>>0";
+  std::ofstream(dev + "scan_elements/in_timestamp_index") << 12;
+
+  std::vector<char> registers(0x12);
+  for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+    if (reg.address < registers.size()) {
+      registers[reg.address] = static_cast<char>(reg.resetValue);
+    }
+  }
+  std::ofstream(dev + "registers", std::ios::binary).write(registers.data(), registers.size());
+
+  std::ofstream buffer(root + "/dev/iio:device0", std::ios::binary);
+  std::vector<char> record(16);
+  for (uint64_t i = 0; i < STREAM_SCANS; i++) {
+    for (size_t c = 0; c < CHANNELS.size(); c++) {
+      int16_t code = static_cast<int16_t>(i + c);
+      memcpy(record.data() + 2 * c, &code, sizeof code);
+    }
+    int64_t ts = static_cast<int64_t>(i) * 250000;
+    memcpy(record.data() + 8, &ts, sizeof ts);
+    buffer.write(record.data(), record.size());
+  }
+  return root;
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  using Reg = ADS114S0XBRegister;
+  bench::Suite suite(METRICS_ENABLED ? "io" : "io-nometrics", argc, argv);
+  const char *prometheusPath = nullptr;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], "--prometheus")) {
+      prometheusPath = argv[i + 1];
+    }
+  }
+  auto root = makeFakeTree();
+  IIOSysfsFilesUtil iioSysfs("iio:device0", root);
+  ADS114S0XB adc(std::make_unique<SysfsBackend>(iioSysfs), iioSysfs);
+  if (auto status = adc.initialize(); status.first != 0) {
+    fprintf(stderr, "%s: %s\n", status.second.c_str(), strerror(status.first));
+    return EXIT_FAILURE;
+  }
+
+  // Control path
+  suite.run("control/readRegister", CONTROL_OPS, [&] {
+    return adc.readRegister(Reg::PGA).has_value();
+  });
+  suite.run("control/writeRegister", CONTROL_OPS, [&] {
+    return adc.writeRegister(Reg::PGA, "8");
+  });
+  suite.run("control/readRegisterValue", CONTROL_OPS, [&] {
+    return adc.readRegisterValue(Reg::PGA).has_value();
+  });
+  bool toggle = false;
+  suite.run("control/set(Pga::Gain) read-modify-write", CONTROL_OPS, [&] {
+    toggle = !toggle;
+    return adc.set(toggle ? Pga::Gain::x2 : Pga::Gain::x4);
+  });
+  suite.run("control/readRegisterBlock PGA..FSCAL1", CONTROL_OPS, [&] {
+    uint8_t regs[13];
+    return adc.readRegisterBlock(0x03, regs).value_or(0) == sizeof regs;
+  });
+  suite.run("control/setBufferWatermark", CONTROL_OPS, [&] {
+    return adc.setBufferWatermark(STREAM_BLOCK);
+  });
+  if (!adc.setBufferLength(4 * STREAM_BLOCK) || !adc.setBufferWatermark(STREAM_BLOCK) ||
+      adc.getBufferLength() != 4 * STREAM_BLOCK ||
+      adc.getBufferWatermark() != STREAM_BLOCK) {
+    fprintf(stderr, "buffer length/watermark did not read back\n");
+    return EXIT_FAILURE;
+  }
+  suite.run("control/setChannel", CONTROL_OPS, [&] {
+    adc.setChannel(CHANNELS[0]);
+    return true;
+  });
+  for (auto channel : CHANNELS) {
+    adc.setChannel(channel);
+  }
+  suite.run("control/enableBuffer", CONTROL_OPS, [&] {
+    adc.enableBuffer();
+    return true;
+  });
+  adc.enableBuffer(); // the decoder below needs the layout, even when filtered out
+  suite.run("control/triggerConversion (ofstream)", CONTROL_OPS, [&] {
+    return adc.triggerConversion();
+  });
+
+  auto session = adc.createStreamingSession();
+  if (auto status = session.open(); status.first != 0) {
+    fprintf(stderr, "%s: %s\n", status.second.c_str(), strerror(status.first));
+    return EXIT_FAILURE;
+  }
+  suite.run("control/StreamingSession::triggerConversion", CONTROL_OPS, [&] {
+    return session.triggerConversion();
+  });
+
+  // Data path, one record per call
+  auto decoder = adc.createScanDecoder();
+  auto recordSize = decoder->recordSize();
+  suite.run("data/readBuffer (ifstream, 1 record)", CONTROL_OPS, [&] {
+    auto data = adc.readBuffer();
+    return data && data->size() == recordSize;
+  }, CHANNELS.size());
+  std::vector<uint8_t> record(recordSize);
+  suite.run("data/StreamingSession::readBuffer (1 record)", CONTROL_OPS, [&] {
+    return session.readBuffer(record) == static_cast<ssize_t>(recordSize);
+  }, CHANNELS.size());
+  session.close();
+
+  // Streaming: batched reads through the decoder, then the full
+  // SysfsBackend source drained by an AcquisitionEngine
+  if (auto status = session.open(); status.first != 0) {
+    return EXIT_FAILURE;
+  }
+  SampleBlock block;
+  decoder->prepare(block, STREAM_BLOCK);
+  suite.runCounted("stream/readRecords x256 + decode", STREAM_SCANS / STREAM_BLOCK, [&] {
+    auto scans = session.readRecords(*decoder, block);
+    return scans < 0 ? scans : scans * static_cast<ssize_t>(CHANNELS.size());
+  });
+  session.close();
+
+  // Same with a poll() ahead of every read. The fake buffer is a regular
+  // file and always readable, so this is the cost of the extra syscall;
+  // on the device each poll() wakeup yields a watermark's worth of scans.
+  session.setPollTimeout(10);
+  if (auto status = session.open(); status.first != 0) {
+    return EXIT_FAILURE;
+  }
+  suite.runCounted("stream/readRecords x256 + decode, poll mode", STREAM_SCANS / STREAM_BLOCK, [&] {
+    auto scans = session.readRecords(*decoder, block);
+    return scans < 0 ? scans : scans * static_cast<ssize_t>(CHANNELS.size());
+  });
+  session.close();
+  session.setPollTimeout(-1);
+
+  adc.disableBuffer();
+  if (suite.enabled("stream/AcquisitionEngine")) {
+    auto source = adc.createSampleSource(STREAM_BLOCK);
+    if (!source) {
+      fprintf(stderr, "createSampleSource: %s\n", strerror(adc.getLastErrno()));
+      return EXIT_FAILURE;
+    }
+    AcquisitionEngine engine(*source, 1 << 16, STREAM_BLOCK);
+    engine.setMetrics(&adc.getMetrics());
+    SampleBlock out;
+    out.reset(engine.channelIds(), 1024);
+    suite.runCounted("stream/AcquisitionEngine end to end", 1, [&] {
+      ssize_t samples = 0;
+      engine.start();
+      while (engine.isRunning() || engine.queued() > 0) {
+        samples += engine.popBatch(out) * out.channelCount();
+      }
+      engine.stop();
+      return engine.getLastErrno() ? -1 : samples;
+    });
+  }
+
+  fs::remove_all(root);
+  if (prometheusPath && !adc.getMetrics().writePrometheus(prometheusPath, "device=\"iio:device0\"")) {
+    perror(prometheusPath);
+  }
+  return suite.report();
+}
@@ -0,0 +1,105 @@
+// Cost of the Metrics primitives on their own: what one counter increment,
+// histogram record or clock read adds to a hot-path call, plus the reader
+// side (snapshot, Prometheus dump). Also checks the histogram percentiles
+// against a known distribution. See io-bench/io-bench-nometrics for the
+// cost on the real read path.
+//
+//   bench/metrics-bench [--json results.json] [--filter histogram/]
+#include <cmath>
+#include <thread>
+
+#include "BenchHarness.h"
+#include "../Metrics.h"
+
+static const uint64_t OPS = 2000;
+static const uint64_t PER_OP = 1000;
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite(METRICS_ENABLED ? "metrics" : "metrics-nometrics", argc, argv);
+  Metrics metrics;
+
+  uint64_t value = 1;
+  suite.run("counter/add", OPS, [&] {
+    for (uint64_t i = 0; i < PER_OP; i++) {
+      metrics.reads.add();
+    }
+    return true;
+  }, PER_OP);
+  suite.run("histogram/record", OPS, [&] {
+    for (uint64_t i = 0; i < PER_OP; i++) {
+      value = value * 6364136223846793005ull + 1442695040888963407ull; // LCG, spreads the buckets
+      metrics.readSyscall.record(value >> 44);
+    }
+    return true;
+  }, PER_OP);
+  suite.run("histogram/recordSince (with clock read)", OPS, [&] {
+    for (uint64_t i = 0; i < PER_OP; i++) {
+      metrics.decode.recordSince(metricsNow());
+    }
+    return true;
+  }, PER_OP);
+
+  // Two writers on one histogram, as when a reader thread and a consumer
+  // share a Metrics
+  suite.run("histogram/record, 2 threads", OPS / 10, [&] {
+    auto work = [&] {
+      for (uint64_t i = 0; i < PER_OP * 10; i++) {
+        metrics.queueResidency.record(i);
+      }
+    };
+    std::thread other(work);
+    work();
+    other.join();
+    return true;
+  }, PER_OP * 20);
+
+  suite.run("reader/snapshot", OPS / 10, [&] {
+    return metrics.snapshot().readSyscall.count > 0 || !METRICS_ENABLED;
+  });
+  suite.run("reader/writePrometheus", OPS / 10, [&] {
+    return metrics.writePrometheus("/tmp/metrics-bench.prom", "device=\"bench\"");
+  });
+  remove("/tmp/metrics-bench.prom");
+
+  // Percentiles of 1..1000000 us must land within the ~6% bucket width
+  if (METRICS_ENABLED && suite.enabled("histogram/percentiles")) {
+    suite.run("histogram/percentiles 1e6 values", 1, [&] {
+      LatencyHistogram uniform;
+      for (uint64_t i = 1; i <= 1000000; i++) {
+        uniform.record(i * 1000);
+      }
+      auto s = uniform.snapshot();
+      for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        double expected = q * 1e9;
+        double got = static_cast<double>(s.percentile(q));
+        if (std::fabs(got - expected) / expected > 0.07) {
+          fprintf(stderr, "p%g: expected %.0f got %.0f\n", q * 100, expected, got);
+          return false;
+        }
+      }
+      return s.count == 1000000 && s.max == 1000000000;
+    });
+  }
+
+  // Past ~18 minutes everything is clamped into the last bucket
+  if (METRICS_ENABLED && suite.enabled("histogram/huge")) {
+    suite.run("histogram/huge values, clamped", 1, [&] {
+      LatencyHistogram huge;
+      const uint64_t values[] = {1ull << 39, (1ull << 40) - 1, 1ull << 45, UINT64_MAX / 2};
+      uint64_t sum = 0;
+      for (auto v : values) {
+        huge.record(v);
+        sum += v;
+      }
+      auto s = huge.snapshot();
+      // 1 << 39 opens the top octave, the other three are in its last bucket
+      return HistogramSnapshot::bucketOf(UINT64_MAX) == HistogramSnapshot::BUCKETS - 1 &&
+        s.buckets[HistogramSnapshot::BUCKETS - 1] == 3 &&
+        s.buckets[HistogramSnapshot::BUCKETS - HistogramSnapshot::SUB_COUNT] == 1 &&
+        s.count == std::size(values) && s.sum == sum && s.max == UINT64_MAX / 2;
+    });
+  }
+
+  return suite.report();
+}
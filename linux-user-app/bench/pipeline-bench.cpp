@@ -0,0 +1,138 @@
+// End-to-end pipeline on the simulated backend: source -> AcquisitionEngine
+// -> volts -> filters. Free-running for throughput, real-time paced well
+// above the chip's 4 kSPS for scan-to-consumer latency. Ends with a check
+// that a source losing every scan still lets the engine stop.
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../ADS114S0XB.h"
+#include "../AcquisitionEngine.h"
+#include "../FilterPipeline.h"
+#include "../SimulatedBackend.h"
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+
+struct Result {
+  double scansPerSecond;
+  std::vector<int64_t> latencyNs;
+  adcs::AcquisitionStats stats;
+  uint64_t dropped;
+};
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static Result run(adcs::SimulatedBackend::Pacing pacing, double rate, uint64_t scans, double dropProbability) {
+  using namespace adcs;
+  auto backend = std::make_unique<SimulatedBackend>();
+  auto &sim = *backend;
+  ADS114S0XB adc(std::move(backend));
+  adc.initialize();
+
+  for (int input = 0; input < 12; input++) {
+    sim.setInput(input, Waveform::sine(0.5, 50.0 + input).withNoise(1e-4));
+  }
+  sim.setPacing(pacing);
+  sim.setSampleRate(rate);
+  sim.setScanLimit(scans);
+  sim.setDropProbability(dropProbability);
+  for (auto channel : CHANNELS) {
+    adc.setChannel(channel);
+  }
+  adc.set(Pga::Mode::Enabled);
+  adc.set(Pga::Gain::x2);
+
+  auto source = adc.createSampleSource(256);
+  if (!source) {
+    fprintf(stderr, "createSampleSource: %s\n", strerror(adc.getLastErrno()));
+    exit(EXIT_FAILURE);
+  }
+  AcquisitionEngine engine(*source, 1 << 16);
+  SampleBlock block;
+  block.reset(engine.channelIds(), 1024);
+  VoltageConverter converter(adc.readConversionParams().value());
+  VoltageBlock volts;
+  converter.prepare(block, volts);
+  FilterPipeline filters;
+  filters.add<BiquadCascade>(std::vector{Biquad::notch(50.0, rate)});
+  filters.setup(volts);
+
+  Result result;
+  result.latencyNs.reserve(scans / 64 + 1);
+  uint64_t consumed = 0;
+  auto start = std::chrono::steady_clock::now();
+  engine.start();
+  while (engine.isRunning() || engine.queued() > 0) {
+    auto n = engine.popBatch(block);
+    if (n == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (pacing == SimulatedBackend::Pacing::RealTime) {
+      // Age of the newest scan in the batch when the consumer gets it
+      result.latencyNs.push_back(nowNs() - block.timestamps[n - 1]);
+    }
+    converter.convert(block, volts);
+    filters.process(volts);
+    consumed += n;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  engine.stop();
+  result.scansPerSecond = consumed / std::chrono::duration<double>(elapsed).count();
+  result.stats = engine.getStats();
+  result.dropped = sim.getDroppedScans();
+  return result;
+}
+
+static int64_t percentile(std::vector<int64_t> &values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(p * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+int main() {
+  using namespace adcs;
+  printf("%zu channels, 256-scan reads, 50 Hz notch\n", CHANNELS.size());
+
+  auto throughput = run(SimulatedBackend::Pacing::FreeRunning, 1e6, 4000000, 0.0);
+  printf("free-running      %10.0f scans/s  overruns %" PRIu64 "\n",
+    throughput.scansPerSecond, throughput.stats.overruns);
+
+  auto paced = run(SimulatedBackend::Pacing::RealTime, 200000, 400000, 0.001);
+  printf("paced 200 kSPS    %10.0f scans/s  latency p50 %" PRId64 " us  p99 %" PRId64 " us  max %" PRId64 " us\n",
+    paced.scansPerSecond,
+    percentile(paced.latencyNs, 0.5) / 1000,
+    percentile(paced.latencyNs, 0.99) / 1000,
+    percentile(paced.latencyNs, 1.0) / 1000);
+  printf("                  %" PRIu64 " scans dropped by the simulator (0.1%%), %" PRIu64 " overruns\n",
+    paced.dropped, paced.stats.overruns);
+
+  // Every scan lost: reads still return, so stop() does not hang
+  auto backend = std::make_unique<SimulatedBackend>();
+  auto &sim = *backend;
+  ADS114S0XB adc(std::move(backend));
+  adc.initialize();
+  adc.setChannel(0);
+  sim.setSampleRate(100000);
+  sim.setDropProbability(1.0);
+  auto source = adc.createSampleSource(256);
+  AcquisitionEngine engine(*source, 1 << 10);
+  engine.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  engine.stop();
+  auto stats = engine.getStats();
+  if (stats.scansRead != 0 || stats.readErrors != 0 || sim.getDroppedScans() == 0) {
+    fprintf(stderr, "drop probability 1: %" PRIu64 " scans read, %" PRIu64 " read errors\n", stats.scansRead, stats.readErrors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+// Replay of a recorded capture: the throughput ceiling of ReplaySource on
+// its own and through AcquisitionEngine, conversion and a notch filter, and
+// checks that every scan and config change comes back as recorded, that
+// paced replay keeps the recorded timing and that a loop keeps time going.
+//
+//   bench/replay-bench [--json results.json] [--filter engine/] [--dir /tmp]
+#include <cinttypes>
+#include <cmath>
+#include <filesystem>
+
+#include "BenchHarness.h"
+#include "../FilterPipeline.h"
+#include "../ReplaySource.h"
+
+namespace fs = std::filesystem;
+
+static const std::vector<int> CHANNELS = {0, 1, 2, 3};
+static const std::vector<int> CHANNELS_AFTER = {1, 5};
+static const size_t BLOCK = 256;
+static const uint64_t SCANS_BEFORE = 1 << 21;
+static const uint64_t SCANS_AFTER = 1 << 19;
+static const int64_t PERIOD_NS = 250000; // 4 kSPS
+static const double RATE = 1e9 / PERIOD_NS;
+
+// Sensor-like codes: a different tone per channel plus noise, recomputed
+// by the checks from the scan number and the channel id.
+static int16_t codeAt(uint64_t scan, int channel) {
+  auto noise = static_cast<int>((scan * 2654435761u + channel * 40503u) >> 13 & 7) - 3;
+  return static_cast<int16_t>(8000 + 100 * channel + 2000 * std::sin(2 * M_PI * (50 + channel) * scan / RATE) + noise);
+}
+
+static adcs::CaptureConfig config(const std::vector<int> &channels, uint8_t pga) {
+  std::array<uint8_t, adcs::CAPTURE_REGISTERS> regs{};
+  for (const auto &reg : adcs::REGISTER_DESCRIPTORS) {
+    if (reg.address < regs.size()) {
+      regs[reg.address] = reg.resetValue;
+    }
+  }
+  regs[adcs::describe(adcs::ADS114S0XBRegister::PGA).address] = pga;
+  return adcs::CaptureConfig::make(channels, regs);
+}
+
+static bool record(const std::string &path) {
+  using namespace adcs;
+  CaptureWriter writer;
+  if (auto status = writer.open(path, config(CHANNELS, 0x00)); status.first != 0) {
+    fprintf(stderr, "%s: %s\n", status.second.c_str(), strerror(status.first));
+    return false;
+  }
+  SampleBlock block;
+  uint64_t scan = 0;
+  auto append = [&](const std::vector<int> &channels, uint64_t scans) {
+    block.reset(channels, BLOCK);
+    for (uint64_t end = scan + scans; scan < end; scan += BLOCK) {
+      for (size_t i = 0; i < BLOCK; i++) {
+        block.timestamps[i] = static_cast<int64_t>(scan + i) * PERIOD_NS;
+        for (size_t c = 0; c < channels.size(); c++) {
+          block.channels[c][i] = codeAt(scan + i, channels[c]);
+        }
+      }
+      block.size = BLOCK;
+      // A full disk queue drops; wait instead, the file has to be complete
+      while (!writer.append(block)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        block.size = BLOCK;
+      }
+    }
+  };
+  append(CHANNELS, SCANS_BEFORE);
+  writer.writeConfig(config(CHANNELS_AFTER, 0x0a));
+  append(CHANNELS_AFTER, SCANS_AFTER);
+  return writer.close().first == 0 && writer.getDroppedScans() == 0;
+}
+
+// Replays the whole capture through the engine; scans consumed and lost.
+static std::pair<uint64_t, uint64_t> runEngine(adcs::ReplaySource &source, double speed, bool lossless) {
+  using namespace adcs;
+  source.setSpeed(speed);
+  source.seek(0);
+  AcquisitionEngine engine(source, 1 << 16, BLOCK);
+  engine.setLossless(lossless);
+  SampleBlock block;
+  block.reset(engine.channelIds(), 1024);
+  VoltageConverter converter(source.configAt(0).conversionParams());
+  VoltageBlock volts;
+  converter.prepare(block, volts);
+  FilterPipeline filters;
+  filters.add<BiquadCascade>(std::vector{Biquad::notch(50.0, RATE)});
+  filters.setup(volts);
+  uint64_t scans = 0;
+  engine.start();
+  while (engine.isRunning() || engine.queued() > 0) {
+    auto n = engine.popBatch(block);
+    if (n == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    converter.convert(block, volts);
+    filters.process(volts);
+    scans += n;
+  }
+  return {scans, engine.getStats().overruns};
+}
+
+int main(int argc, char **argv) {
+  using namespace adcs;
+  bench::Suite suite("replay", argc, argv);
+  std::string dir = "/tmp";
+  for (int i = 1; i + 1 < argc; i++) {
+    if (!strcmp(argv[i], "--dir")) {
+      dir = argv[i + 1];
+    }
+  }
+  auto path = dir + "/replay-bench-" + std::to_string(getpid()) + ".cap";
+  if (!record(path)) {
+    fs::remove(path);
+    return EXIT_FAILURE;
+  }
+  const auto total = SCANS_BEFORE + SCANS_AFTER;
+
+  ReplaySource source;
+  if (auto status = source.open(path); status.first != 0) {
+    fprintf(stderr, "%s: %s\n", status.second.c_str(), strerror(status.first));
+    return EXIT_FAILURE;
+  }
+  source.setSpeed(0);
+  SampleBlock block;
+  source.prepare(block, BLOCK);
+
+  suite.runCounted("read/whole capture, 256-scan reads", 20, [&] {
+    source.seek(0);
+    ssize_t scans = 0;
+    for (ssize_t n; (n = source.read(block)) > 0;) {
+      scans += n;
+    }
+    return scans == static_cast<ssize_t>(total) ? scans : -1;
+  });
+
+  // Ceiling of the pipeline with recorded data. Free running, the reader
+  // waits for the consumer (lossless), so items/s is the consumer's pace
+  // and every scan must arrive. Paced at 1000x (4 MSPS) it does not wait,
+  // as with the device, and loses whatever the consumer cannot keep up with.
+  for (double speed : {0.0, 1000.0}) {
+    uint64_t overruns = 0;
+    bool lossless = speed == 0;
+    auto name = speed ? "engine/paced 1000x -> volts -> notch" : "engine/free running -> volts -> notch";
+    suite.runCounted(name, speed ? 1 : 5, [&] {
+      auto result = runEngine(source, speed, lossless);
+      overruns += result.second;
+      if (result.first + result.second != total || (lossless && result.second != 0)) {
+        return ssize_t{-1};
+      }
+      return static_cast<ssize_t>(result.first);
+    });
+    if (suite.enabled(name)) {
+      printf("%s: %" PRIu64 " scans lost to ring overruns\n", name, overruns);
+    }
+  }
+  source.setSpeed(0);
+
+  suite.run("check/every scan and config change", 1, [&] {
+    std::vector<std::pair<uint8_t, int64_t>> changes;
+    source.setConfigCallback([&](const CaptureConfig &cfg, int64_t first) {
+      changes.emplace_back(cfg.reg(ADS114S0XBRegister::PGA), first);
+    });
+    source.seek(0);
+    uint64_t scan = 0;
+    for (ssize_t n; (n = source.read(block)) > 0;) {
+      // A block never straddles the change
+      bool after = scan >= SCANS_BEFORE;
+      if (after != (scan + n - 1 >= SCANS_BEFORE)) {
+        return false;
+      }
+      const auto &channels = after ? CHANNELS_AFTER : CHANNELS;
+      for (ssize_t i = 0; i < n; i++, scan++) {
+        if (block.timestamps[i] != static_cast<int64_t>(scan) * PERIOD_NS) {
+          return false;
+        }
+        for (size_t c = 0; c < block.channelCount(); c++) {
+          auto id = block.channelIds[c];
+          bool recorded = std::find(channels.begin(), channels.end(), id) != channels.end();
+          if (block.channels[c][i] != (recorded ? codeAt(scan, id) : 0)) {
+            return false;
+          }
+        }
+      }
+    }
+    source.setConfigCallback(nullptr);
+    auto changeAt = static_cast<int64_t>(SCANS_BEFORE) * PERIOD_NS;
+    return scan == total && block.channelIds == std::vector<int>{0, 1, 2, 3, 5} &&
+      changes == std::vector<std::pair<uint8_t, int64_t>>{{0x00, 0}, {0x0a, changeAt}} &&
+      source.configAt(changeAt - 1).channelCount == 4 && source.configAt(changeAt).channelCount == 2;
+  });
+
+  // The last 2 s as recorded, at 20x: 100 ms
+  suite.run("check/paced 20x keeps the recorded timing", 1, [&] {
+    const double speed = 20;
+    auto from = static_cast<int64_t>(total - 2 * static_cast<uint64_t>(RATE)) * PERIOD_NS;
+    source.setSpeed(speed);
+    source.seek(from);
+    auto start = std::chrono::steady_clock::now();
+    int64_t last = from;
+    for (ssize_t n; (n = source.read(block)) > 0;) {
+      last = block.timestamps[n - 1];
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double expected = static_cast<double>(last - from) / 1e9 / speed;
+    source.setSpeed(0);
+    if (elapsed < expected || elapsed > expected * 1.5 + 0.01) {
+      fprintf(stderr, "paced replay took %.3f s, expected %.3f s\n", elapsed, expected);
+      return false;
+    }
+    return true;
+  });
+
+  suite.run("check/loop keeps timestamps increasing", 1, [&] {
+    source.setLoop(true);
+    source.seek(0);
+    int64_t previous = -1;
+    uint64_t scans = 0;
+    while (scans < 2 * total + total / 2) {
+      auto n = source.read(block);
+      if (n <= 0) {
+        return false;
+      }
+      for (ssize_t i = 0; i < n; i++) {
+        if (block.timestamps[i] != previous + PERIOD_NS && previous >= 0) {
+          return false;
+        }
+        previous = block.timestamps[i];
+      }
+      scans += static_cast<uint64_t>(n);
+    }
+    source.setLoop(false);
+    // Third pass, before the change
+    return source.configAt(previous).channelCount == 4;
+  });
+
+  fs::remove(path);
+  return suite.report();
+}
@@ -10,23 +10,44 @@ void readAdcData (adcs::ADS114S0XB &adc, int channel, int count) {
   adc.setChannel(channel);
   adc.enableBuffer();
 
-  for (int i = 0; i < count; i++) {
-    if (!adc.triggerConversion()) {
-      std::cout << "Error triggering." << std::endl;
-      break;
-    }
-    // Read and display buffer data
-    auto data = adc.readBuffer();
-    if (data) {
-      std::cout << "ADC data: ";
-      for (auto byte : data.value()) {
-        std::cout << std::hex << static_cast<int>(byte) << " ";
+  // Trigger and buffer descriptors stay open for the whole loop
+  auto session = adc.createStreamingSession();
+  auto decoder = adc.createScanDecoder();
+  if (!decoder) {
+    std::cout << "Error reading scan elements layout" << std::endl;
+  }
+  else if (auto status = session.open(); status.first != 0) {
+    std::cout << "Error opening streaming session (" << status.second
+              << "): " << strerror(status.first) << std::endl;
+  }
+  else {
+    SampleBlock block;
+    decoder->prepare(block, 1);
+    // Codes to volts for the current PGA/REF setup
+    VoltageConverter converter(adc.readConversionParams().value_or(ConversionParams()));
+    VoltageBlock volts;
+    converter.prepare(block, volts);
+    for (int i = 0; i < count; i++) {
+      if (!session.triggerConversion()) {
+        std::cout << "Error triggering." << std::endl;
+        break;
+      }
+      // Read and display one decoded record
+      if (session.readRecords(*decoder, block) > 0) {
+        converter.convert(block, volts);
+        std::cout << "ADC data:";
+        for (size_t c = 0; c < block.channelCount(); c++) {
+          std::cout << " ch" << std::dec << block.channelIds[c]
+                    << "=0x" << std::hex << static_cast<uint16_t>(block.channels[c][0])
+                    << std::dec << " (" << volts.channels[c][0] << " V)";
+        }
+        std::cout << std::dec << " ts=" << block.timestamps[0] << std::endl;
+      }
+      else {
+        std::cout << "Error reading ADC data" << std::endl;
       }
-      std::cout << std::endl;
-    }
-    else {
-      std::cout << "Error reading ADC data" << std::endl;
     }
+    session.close();
   }
   adc.resetChannel(channel);
   adc.disableBuffer();
@@ -64,15 +85,14 @@ void writeRegisters(adcs::ADS114S0XB &adc) {
 
   // Writing ALL registers
   for (auto &reg_id : adc.registerMap) {
-    if (auto size = adc.writeRegister(reg_id.first, "5")) {
+    if (adc.writeRegister(reg_id.first, "5")) {
       std::cout 
         << "Write " << reg_id.second 
-        << " register sucess: " << size.value()
-        << " bytes"
+        << " register sucess"
         << std::endl;
     }
     else {
-      std::cout << "Error reading register" << std::endl;
+      std::cout << "Error writing " << reg_id.second << ": " << strerror(adc.getLastErrno()) << std::endl;
     }
   }
 }
@@ -49,6 +49,29 @@ configure_iio_interface() {
     echo "IIO interface configured."
 }
 
+# The driver's own hrtimer trigger instead of iio-trig-sysfs: no
+# trigger_now writes, the kernel paces the scans
+configure_timer_trigger() {
+    local dev="/sys/bus/iio/devices/$IIO_INTERFACE"
+    local name trig
+    if [[ ! -d "$dev" ]]; then
+        echo "Error: IIO interface '$IIO_INTERFACE' not found in /sys/bus/iio/devices."
+        return 1
+    fi
+
+    name="$(cat "$dev/name")-dev${IIO_INTERFACE#iio:device}-timer"
+    trig=$(grep -lx "$name" /sys/bus/iio/devices/trigger*/name | xargs -r dirname)
+    if [[ -z "$trig" ]]; then
+        echo "Error: trigger '$name' not found."
+        return 1
+    fi
+
+    read -p "Sampling frequency in Hz: " rate
+    echo "$rate" > "$trig/sampling_frequency"
+    echo "$name" > "$dev/trigger/current_trigger"
+    echo "Using $name at $(cat "$trig/sampling_frequency") Hz (clamped to the data rate)."
+}
+
 unload_adc_driver() {
     echo "Unloading the ADS114S0XB driver..."
     pushd ../linux-embedded-driver > /dev/null
@@ -66,8 +89,9 @@ show_menu() {
         echo "2. Load ADS114S0XB driver"
         echo "3. Install ADS114S0XB driver"
         echo "4. Configure IIO interface"
-        echo "5. Unload ADS114S0XB driver"
-        echo "6. Exit"
+        echo "5. Use the driver's timer trigger"
+        echo "6. Unload ADS114S0XB driver"
+        echo "7. Exit"
         echo "=================================="
         read -p "Select an option: " option
 
@@ -76,8 +100,9 @@ show_menu() {
             2) load_adc_driver ;;
             3) install_adc_driver ;;
             4) configure_iio_interface ;;
-            5) unload_adc_driver ;;
-            6) echo "Exiting..."; exit 0 ;;
+            5) configure_timer_trigger ;;
+            6) unload_adc_driver ;;
+            7) echo "Exiting..."; exit 0 ;;
             *) echo "Invalid option. Please try again." ;;
         esac
     done